@@ -0,0 +1,38 @@
+#!/usr/bin/env bash
+# Runs the --bench mode against the offline yt-dlp stub for a few output
+# loads and appends one JSON line per run to the results file, tagged with
+# the current commit. No network or display server is needed.
+#
+# Usage: scripts/bench.sh [results file] (default: bench-results.jsonl)
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+EXEC_PATH="${BENCH_EXEC:-$ROOT_DIR/release/yt-dlp-GUI}"
+RESULTS="${1:-bench-results.jsonl}"
+LABEL="$(git -C "$ROOT_DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)"
+
+if [ ! -x "$EXEC_PATH" ]; then
+    echo "Executable not found: $EXEC_PATH (build first or set BENCH_EXEC)" >&2
+    exit 1
+fi
+
+run() {
+    echo "bench: $*"
+    "$EXEC_PATH" --bench --yt-dlp "$SCRIPT_DIR/stub-yt-dlp.sh" --label "$LABEL" --out "$RESULTS" "$@"
+}
+
+# progress only, a few long downloads
+run --jobs 4 --parallel 4 --steps 2000 --noise-lines 0
+# chatty output, many downloads at once
+run --jobs 32 --parallel 8 --steps 200 --noise-lines 20 --line-bytes 200
+# realistic pacing, mostly measures time to first progress
+run --jobs 8 --parallel 4 --steps 20 --delay 0.05 --noise-lines 2
+# global bandwidth budget, compare achieved_rate with target_rate
+run --jobs 6 --parallel 3 --steps 40 --noise-lines 0 --limit-rate 8M
+# a long queue in the table, loop latency must stay flat
+run --jobs 10000 --parallel 16 --steps 5 --noise-lines 0
+# theme switching on a window-sized widget tree
+"$EXEC_PATH" --bench --theme-switches 50 --label "$LABEL" --out "$RESULTS"
+
+echo "Results appended to $RESULTS"
@@ -0,0 +1,215 @@
+#!/usr/bin/env bash
+# Offline stand-in for yt-dlp, used to exercise the download queue
+# without network access. Copy it to release/deps/yt-dlp.
+#
+# Environment:
+#   STUB_STEPS       progress lines per download (default 20)
+#   STUB_DELAY       seconds between progress lines (default 0.1)
+#   STUB_EXIT_CODE   exit code to finish with (default 0)
+#   STUB_PLAYLIST    entries listed for "list=" URLs (default 5)
+#   STUB_STEP_BYTES  bytes "downloaded" per progress line (default 262144)
+#   STUB_NOISE       extra log lines printed per progress line (default 0)
+#   STUB_LINE_BYTES  length of each extra log line (default 80)
+#   STUB_ERROR       message of the ERROR line a failure ends with
+#                    (default "stub failure requested"), e.g. "HTTP Error 429: Too Many Requests"
+#   STUB_FAIL_TIMES  fail this many runs per URL with STUB_EXIT_CODE (or 1), then succeed
+#   STUB_HOST_LIMIT  answer HTTP 429 when more downloads than this run against one host
+#                    at once (default 0, no limit); --sleep-interval is honoured
+#
+# -P home:dir and -P temp:dir are honoured like yt-dlp does: a relative -o is
+# written under temp (or home) and moved to home at the end with a
+# "[MoveFiles] Moving file" line.
+
+STEPS="${STUB_STEPS:-20}"
+DELAY="${STUB_DELAY:-0.1}"
+EXIT_CODE="${STUB_EXIT_CODE:-0}"
+PLAYLIST_SIZE="${STUB_PLAYLIST:-5}"
+STEP_BYTES="${STUB_STEP_BYTES:-262144}"
+NOISE="${STUB_NOISE:-0}"
+LINE_BYTES="${STUB_LINE_BYTES:-80}"
+ERROR_MESSAGE="${STUB_ERROR:-stub failure requested}"
+FAIL_TIMES="${STUB_FAIL_TIMES:-0}"
+HOST_LIMIT="${STUB_HOST_LIMIT:-0}"
+
+URL=""
+OUTPUT="%(title)s.%(ext)s"
+TEMPLATE=0
+JSON=0
+LIMIT_RATE=0
+FORMAT=""
+THUMBNAIL=0
+THUMB_EXT=webp
+FLAT=0
+SLEEP_INTERVAL=0
+HOME_DIR=""
+TEMP_DIR=""
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --version) echo "2099.01.01-stub"; exit 0 ;;
+        -U) echo "yt-dlp is up to date (stub)"; exit 0 ;;
+        -o) OUTPUT="$2"; shift ;;
+        -P|--paths)
+            case "$2" in
+                home:*) HOME_DIR="${2#home:}" ;;
+                temp:*) TEMP_DIR="${2#temp:}" ;;
+                *) HOME_DIR="$2" ;;
+            esac
+            shift ;;
+        --progress-template) TEMPLATE=1; shift ;;
+        --limit-rate) LIMIT_RATE="$2"; shift ;;
+        -J|--dump-single-json) JSON=1 ;;
+        --flat-playlist) FLAT=1 ;;
+        -f|--format) FORMAT="$2"; shift ;;
+        --write-thumbnail) THUMBNAIL=1 ;;
+        --convert-thumbnails) THUMB_EXT="$2"; shift ;;
+        --sleep-interval) SLEEP_INTERVAL="$2"; shift ;;
+        --sleep-requests|--max-sleep-interval) shift ;;
+        --merge-output-format|--audio-format|--audio-quality|--ffmpeg-location|--cookies-from-browser) shift ;;
+        http://*|https://*) URL="$1" ;;
+    esac
+    shift
+done
+
+if [ -z "$URL" ]; then
+    echo "ERROR: no URL given" >&2
+    exit 2
+fi
+
+ID="$(printf '%s' "$URL" | cksum | cut -d' ' -f1)"
+
+if [ "$JSON" -eq 1 ] && [ "$FLAT" -eq 1 ]; then
+    echo -n "{\"_type\": \"playlist\", \"id\": \"PL$ID\", \"title\": \"stub playlist\", \"entries\": ["
+    for i in $(seq 1 "$PLAYLIST_SIZE"); do
+        [ "$i" -gt 1 ] && echo -n ", "
+        echo -n "{\"_type\": \"url\", \"ie_key\": \"Generic\", \"id\": \"$ID$i\", \"url\": \"https://stub.invalid/watch?v=$ID$i\", \"title\": \"entry $i\"}"
+    done
+    echo "]}"
+    exit 0
+fi
+
+if [ "$JSON" -eq 1 ]; then
+    cat <<EOF
+{"id": "$ID", "extractor_key": "Generic", "title": "stub video $ID", "uploader": "stub", "duration": 60,
+ "webpage_url": "$URL", "formats": [
+  {"format_id": "18", "ext": "mp4", "vcodec": "avc1.42001E", "acodec": "mp4a.40.2", "width": 640, "height": 360, "tbr": 500, "filesize": 3750000},
+  {"format_id": "137", "ext": "mp4", "vcodec": "avc1.640028", "acodec": "none", "width": 1920, "height": 1080, "tbr": 4000, "filesize": 30000000},
+  {"format_id": "248", "ext": "webm", "vcodec": "vp9", "acodec": "none", "width": 1920, "height": 1080, "tbr": 2600, "filesize": 19500000},
+  {"format_id": "140", "ext": "m4a", "vcodec": "none", "acodec": "mp4a.40.2", "abr": 129, "filesize": 970000},
+  {"format_id": "251", "ext": "webm", "vcodec": "none", "acodec": "opus", "abr": 135, "filesize": 1010000}
+ ]}
+EOF
+    exit 0
+fi
+FILE="$OUTPUT"
+FILE="${FILE//%(title)s/stub video $ID}"
+FILE="${FILE//%(id)s/$ID}"
+# raw audio downloads keep the audio stream's own container
+EXT="mp4"
+case "$FORMAT" in
+    bestaudio*|251) EXT="webm" ;;
+    140) EXT="m4a" ;;
+esac
+FILE="${FILE//%(ext)s/$EXT}"
+FILE="${FILE//%(playlist)s/stub playlist}"
+FILE="${FILE//%(playlist_index)03d/001}"
+
+# a relative name goes under -P home:, and while downloading under -P temp:
+FINAL="$FILE"
+if [ "${FILE#/}" = "$FILE" ]; then
+    [ -n "$HOME_DIR" ] && FINAL="$HOME_DIR/$FILE"
+    FILE="$FINAL"
+    [ -n "$TEMP_DIR" ] && FILE="$TEMP_DIR/${FINAL#"$HOME_DIR"/}"
+fi
+
+[ "$SLEEP_INTERVAL" != "0" ] && sleep "$SLEEP_INTERVAL"
+
+# a site that throttles clients holding too many connections
+if [ "$HOST_LIMIT" -gt 0 ]; then
+    HOST="$(printf '%s' "$URL" | sed -E 's|^[a-z]+://([^/:]+).*|\1|')"
+    SLOTS="${TMPDIR:-/tmp}/stub-yt-dlp-hosts/$HOST"
+    mkdir -p "$SLOTS"
+    : > "$SLOTS/$$"
+    trap 'rm -f "$SLOTS/$$"' EXIT
+    if [ "$(ls "$SLOTS" | wc -l)" -gt "$HOST_LIMIT" ]; then
+        echo "[generic] Extracting URL: $URL"
+        echo "ERROR: [generic] Unable to download webpage: HTTP Error 429: Too Many Requests" >&2
+        exit 1
+    fi
+fi
+
+echo "[generic] Extracting URL: $URL"
+echo "[generic] $ID: Downloading webpage"
+echo "[info] $ID: Downloading 1 format(s): 18"
+echo "[download] Destination: $FILE"
+
+# like yt-dlp, data goes to a .part file that is renamed when complete
+mkdir -p "$(dirname "$FILE")"
+: > "$FILE.part"
+
+# with --limit-rate (plain bytes per second) progress is paced to that rate
+SPEED="2621440.0"
+if [ "$LIMIT_RATE" -gt 0 ] 2>/dev/null; then
+    SPEED="$LIMIT_RATE.0"
+    DELAY="$(awk -v b="$STEP_BYTES" -v r="$LIMIT_RATE" 'BEGIN { printf "%.3f", b / r }')"
+fi
+
+# with --progress-template the GUI's machine readable format is printed
+TOTAL=$((STEPS * STEP_BYTES))
+NOISE_LINE="[debug] $(head -c "$LINE_BYTES" /dev/zero | tr '\0' 'x')"
+for i in $(seq 1 "$STEPS"); do
+    if [ "$TEMPLATE" -eq 1 ]; then
+        echo "[ytgui-dl] downloading|$((i * STEP_BYTES))|$TOTAL|NA|$SPEED|$((STEPS - i))|$i|$STEPS|Generic|$ID"
+    else
+        PCT=$((i * 100 / STEPS))
+        echo "[download]  $PCT.0% of $((TOTAL / 1048576)).00MiB at  2.50MiB/s ETA 00:0$(( (STEPS - i) % 10 ))"
+    fi
+    for _ in $(seq 1 "$NOISE"); do
+        echo "$NOISE_LINE"
+    done
+    [ "$DELAY" != "0" ] && sleep "$DELAY"
+done
+
+# failures counted per URL across runs, for exercising retries
+if [ "$FAIL_TIMES" -gt 0 ]; then
+    COUNTER="${TMPDIR:-/tmp}/stub-yt-dlp-$ID.fails"
+    FAILED="$(cat "$COUNTER" 2>/dev/null || echo 0)"
+    if [ "$FAILED" -lt "$FAIL_TIMES" ]; then
+        echo $((FAILED + 1)) > "$COUNTER"
+        [ "$EXIT_CODE" -eq 0 ] && EXIT_CODE=1
+    else
+        rm -f "$COUNTER"
+        EXIT_CODE=0
+    fi
+fi
+
+if [ "$EXIT_CODE" -ne 0 ]; then
+    echo "ERROR: [generic] $ID: $ERROR_MESSAGE" >&2
+    exit "$EXIT_CODE"
+fi
+
+head -c 1024 /dev/zero > "$FILE.part"
+mv "$FILE.part" "$FILE"
+if [ "$THUMBNAIL" -eq 1 ]; then
+    echo "[info] Writing video thumbnail 0 to: ${FILE%.*}.webp"
+    head -c 512 /dev/zero > "${FILE%.*}.webp"
+    if [ "$THUMB_EXT" != webp ]; then
+        echo "[ThumbnailsConvertor] Converting thumbnail \"${FILE%.*}.webp\" to $THUMB_EXT"
+        mv "${FILE%.*}.webp" "${FILE%.*}.$THUMB_EXT"
+    fi
+fi
+if [ "$FILE" != "$FINAL" ]; then
+    mkdir -p "$(dirname "$FINAL")"
+    echo "[MoveFiles] Moving file \"$FILE\" to \"$FINAL\""
+    mv "$FILE" "$FINAL"
+    if [ "$THUMBNAIL" -eq 1 ]; then
+        echo "[MoveFiles] Moving file \"${FILE%.*}.$THUMB_EXT\" to \"${FINAL%.*}.$THUMB_EXT\""
+        mv "${FILE%.*}.$THUMB_EXT" "${FINAL%.*}.$THUMB_EXT"
+    fi
+fi
+if [ "$TEMPLATE" -eq 1 ]; then
+    echo "[ytgui-dl] finished|$TOTAL|$TOTAL|NA|NA|NA|NA|NA|Generic|$ID"
+else
+    echo "[download] 100% of $((TOTAL / 1048576)).00MiB in 00:00:0$((STEPS / 10 % 10))"
+fi
+exit 0
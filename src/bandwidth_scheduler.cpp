@@ -0,0 +1,282 @@
+#include "bandwidth_scheduler.hpp"
+
+#include <QRegularExpression>
+#include <QtGlobal>
+#include <utility>
+
+
+bool BandwidthRule::covers(const QTime &t) const
+{
+    if (from <= to)
+        return t >= from && t < to;
+
+    // wraps past midnight, e.g. 22:00-06:00
+    return t >= from || t < to;
+}
+
+
+// ---------- parsing ----------
+qint64 BandwidthScheduler::parseRate(const QString &text, bool *ok)
+{
+    static const QRegularExpression re("^\\s*(\\d+(?:\\.\\d+)?)\\s*([KMG]?)i?B?\\s*$",
+                                       QRegularExpression::CaseInsensitiveOption);
+
+    if (ok) *ok = true;
+
+    QString t = text.trimmed().toLower();
+    if (t.isEmpty() || t == "off" || t == "unlimited") { return 0; }
+
+    QRegularExpressionMatch m = re.match(t);
+    if (!m.hasMatch())
+    {
+        if (ok) *ok = false;
+        return 0;
+    }
+
+    double value = m.captured(1).toDouble();
+    QString unit = m.captured(2).toUpper();
+    if (unit == "K") value *= 1024;
+    else if (unit == "M") value *= 1024 * 1024;
+    else if (unit == "G") value *= 1024.0 * 1024 * 1024;
+
+    return static_cast<qint64>(value);
+}
+
+bool BandwidthScheduler::parseSchedule(const QString &text, QList<BandwidthRule> &out)
+{
+    out.clear();
+
+    const QStringList parts = text.split(QRegularExpression("[;,]"), Qt::SkipEmptyParts);
+    for (const QString &part : parts)
+    {
+        // "HH:mm-HH:mm=value"
+        QString span = part.section('=', 0, 0).trimmed();
+        QString value = part.section('=', 1).trimmed();
+
+        BandwidthRule r;
+        r.from = QTime::fromString(span.section('-', 0, 0).trimmed(), "H:mm");
+        r.to = QTime::fromString(span.section('-', 1, 1).trimmed(), "H:mm");
+        if (!r.from.isValid() || !r.to.isValid() || value.isEmpty()) { return false; }
+
+        if (value.compare("pause", Qt::CaseInsensitive) == 0)
+        {
+            r.paused = true;
+        }
+        else
+        {
+            bool ok = false;
+            r.bytesPerSec = parseRate(value, &ok);
+            if (!ok) { return false; }
+        }
+
+        out << r;
+    }
+    return true;
+}
+
+
+// ---------- BandwidthScheduler ----------
+BandwidthScheduler::BandwidthScheduler(DownloadQueue *queue, QObject *parent)
+    : QObject(parent), queue(queue)
+{
+    queue->addLaunchArgs([this](int id) { return launchArgs(id); });
+    queue->setAdmission([this] { return !paused; });
+
+    connect(queue, &DownloadQueue::jobProgress, this, &BandwidthScheduler::jobProgress);
+    connect(queue, &DownloadQueue::jobQueued, this, &BandwidthScheduler::jobGone);
+    connect(queue, &DownloadQueue::jobFinished, this, [this](int id) { jobGone(id); });
+
+    clock.start();
+    tick.setInterval(1000);
+    connect(&tick, &QTimer::timeout, this, &BandwidthScheduler::evaluate);
+    tick.start();
+}
+
+void BandwidthScheduler::setLimit(qint64 bytesPerSec)
+{
+    baseLimit = qMax<qint64>(0, bytesPerSec);
+    evaluate();
+}
+
+void BandwidthScheduler::setSchedule(const QList<BandwidthRule> &r)
+{
+    rules = r;
+    evaluate();
+}
+
+QStringList BandwidthScheduler::launchArgs(int id)
+{
+    Slot s;
+    s.startedAt = clock.elapsed();
+    s.lastBytes = -1;
+
+    if (target > 0)
+    {
+        // what the other jobs leave over, split with the jobs that may still start
+        qint64 used = 0;
+        for (const Slot &other : std::as_const(jobSlots))
+            used += other.rate;
+
+        int freeWorkers = qMax(1, queue->maxWorkers() - int(jobSlots.size()));
+        int sharers = qMax(1, qMin(freeWorkers, queue->pendingCount() + 1));
+        s.rate = qMax(minJobRate, (target - used) / sharers);
+
+        // the running jobs took the budget: this one gets an even share and
+        // those above it are restarted, coming back with what is left
+        qint64 fair = qMax(minJobRate, target / (int(jobSlots.size()) + 1));
+        if (s.rate < fair)
+        {
+            s.rate = fair;
+            QList<int> over;
+            for (auto it = jobSlots.cbegin(); it != jobSlots.cend(); ++it)
+                if (it->rate > fair) { over << it.key(); }
+            QMetaObject::invokeMethod(this, [this, over] { scaleDown(over); }, Qt::QueuedConnection);
+        }
+    }
+
+    jobSlots.insert(id, s);
+
+    if (s.rate == 0) { return {}; }
+    return {"--limit-rate", QString::number(s.rate)};
+}
+
+
+// ---------- rebalancing ----------
+void BandwidthScheduler::evaluate()
+{
+    qint64 now = clock.elapsed();
+    qint64 dt = now - lastTickAt;
+    if (dt > 0)
+    {
+        achieved = (achieved + bytesThisTick * 1000 / dt) / 2;
+        bytesThisTick = 0;
+        lastTickAt = now;
+    }
+
+    qint64 newTarget = baseLimit;
+    bool newPaused = false;
+    QTime t = QTime::currentTime();
+    for (const BandwidthRule &r : std::as_const(rules))
+    {
+        if (!r.covers(t)) { continue; }
+        newTarget = r.bytesPerSec;
+        newPaused = r.paused;
+        break;
+    }
+
+    if (newPaused != paused || newTarget != target)
+    {
+        bool shrank = newTarget > 0 && (target == 0 || newTarget < target);
+        bool resumed = paused && !newPaused;
+
+        target = newTarget;
+        paused = newPaused;
+
+        if (paused)
+        {
+            // running jobs go back to the queue and wait there
+            const QList<int> running = jobSlots.keys();
+            for (int id : running)
+            {
+                jobSlots.remove(id);
+                queue->restart(id);
+            }
+        }
+        else
+        {
+            rebalance(shrank);
+            if (resumed)
+                queue->wake();
+        }
+    }
+    else
+    {
+        rebalance(false);
+    }
+
+    emit rateChanged(achieved, target);
+}
+
+// not from launchArgs() itself, the queue is starting a job right then
+void BandwidthScheduler::scaleDown(const QList<int> &ids)
+{
+    for (int id : ids)
+    {
+        if (!jobSlots.contains(id)) { continue; }
+        jobSlots.remove(id);
+        queue->restart(id);
+    }
+}
+
+void BandwidthScheduler::rebalance(bool budgetShrank)
+{
+    if (paused) { return; }
+
+    if (budgetShrank)
+    {
+        // everything is relaunched with a share of the new budget
+        const QList<int> running = jobSlots.keys();
+        for (int id : running)
+        {
+            jobSlots.remove(id);
+            queue->restart(id);
+        }
+        return;
+    }
+
+    // the budget is meant for waiting jobs first
+    if (queue->pendingCount() > 0) { return; }
+
+    qint64 now = clock.elapsed();
+    qint64 used = 0;
+    for (const Slot &s : std::as_const(jobSlots))
+        used += s.rate;
+
+    // at most one restart per tick, the one that gains the most
+    int best = 0;
+    qint64 bestGain = 0;
+    for (auto it = jobSlots.cbegin(); it != jobSlots.cend(); ++it)
+    {
+        const Slot &s = it.value();
+        if (s.rate == 0) { continue; }
+        if (now - s.startedAt < minRunBeforeUpgradeMs) { continue; }
+
+        qint64 available = (target == 0) ? -1 : target - (used - s.rate);
+        bool faster = (available < 0) || (s.rate * 3 / 2 < available);
+        qint64 gain = (available < 0) ? s.rate : available - s.rate;
+        if (faster && gain > bestGain)
+        {
+            best = it.key();
+            bestGain = gain;
+        }
+    }
+
+    if (best != 0)
+    {
+        jobSlots.remove(best);
+        queue->restart(best);
+    }
+}
+
+
+// ---------- accounting ----------
+void BandwidthScheduler::jobProgress(int id, const ProgressEvent &ev)
+{
+    if (ev.kind != ProgressEvent::Kind::Download) { return; }
+
+    auto it = jobSlots.find(id);
+    if (it == jobSlots.end()) { return; }
+
+    // the first line after a (re)start only sets the baseline
+    if (it->lastBytes >= 0 && ev.downloadedBytes > it->lastBytes)
+    {
+        bytesThisTick += ev.downloadedBytes - it->lastBytes;
+        bytesTotal += ev.downloadedBytes - it->lastBytes;
+    }
+    it->lastBytes = ev.downloadedBytes;
+}
+
+void BandwidthScheduler::jobGone(int id)
+{
+    jobSlots.remove(id);
+}
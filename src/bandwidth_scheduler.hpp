@@ -0,0 +1,95 @@
+#ifndef BANDWIDTH_SCHEDULER_HPP
+#define BANDWIDTH_SCHEDULER_HPP
+
+#include "download_queue.hpp"
+#include <QObject>
+#include <QTime>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+
+
+// "08:00-18:00=2M": from, to (may wrap past midnight) and a budget in
+// bytes per second, 0 for unlimited; a paused rule starts nothing
+struct BandwidthRule
+{
+    QTime from;
+    QTime to;
+    qint64 bytesPerSec = 0;
+    bool paused = false;
+
+    bool covers(const QTime &t) const;
+};
+
+// Splits one global rate budget across all yt-dlp processes of a queue.
+// A job is started with "--limit-rate" set to what the running jobs leave
+// of the budget, divided among the free slots the waiting jobs will fill,
+// so the total stays under budget. When the running jobs leave less than
+// an even share, the new job gets one anyway and the jobs above it are
+// restarted (resuming their .part file) to make room. Every running job is
+// restarted whenever the budget shrinks, and one at a time when nothing
+// waits and the unused budget would let a job that ran long enough go
+// noticeably faster.
+class BandwidthScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BandwidthScheduler(DownloadQueue *queue, QObject *parent = nullptr);
+
+    // bytes per second for all jobs together, 0 for unlimited
+    void setLimit(qint64 bytesPerSec);
+    qint64 limit() const { return baseLimit; }
+
+    // time-of-day rules override the limit while they apply
+    void setSchedule(const QList<BandwidthRule> &rules);
+
+    // "08:00-18:00=2M; 18:00-23:00=0; 01:00-06:00=pause", sizes in bytes with K/M/G suffixes
+    static bool parseSchedule(const QString &text, QList<BandwidthRule> &rules);
+    static qint64 parseRate(const QString &text, bool *ok = nullptr);
+
+    // effective budget right now, 0 for unlimited
+    qint64 targetRate() const { return target; }
+    bool isPaused() const { return paused; }
+
+    // measured from progress lines, smoothed over a few seconds
+    qint64 achievedRate() const { return achieved; }
+    qint64 totalBytes() const { return bytesTotal; }
+
+signals:
+    void rateChanged(qint64 achieved, qint64 target);
+
+private:
+    DownloadQueue* queue;
+    qint64 baseLimit = 0;
+    QList<BandwidthRule> rules;
+
+    qint64 target = 0;
+    bool paused = false;
+
+    // what each running job was started with, and when
+    struct Slot { qint64 rate = 0; qint64 startedAt = 0; qint64 lastBytes = 0; };
+    QHash<int, Slot> jobSlots;
+
+    QTimer tick;
+    QElapsedTimer clock;
+    qint64 bytesThisTick = 0;
+    qint64 lastTickAt = 0;
+    qint64 achieved = 0;
+    qint64 bytesTotal = 0;
+
+    QStringList launchArgs(int id);
+    void evaluate();
+    void rebalance(bool budgetShrank);
+    void scaleDown(const QList<int> &ids);
+
+    void jobProgress(int id, const ProgressEvent &ev);
+    void jobGone(int id);
+
+    static constexpr qint64 minJobRate = 16 * 1024;
+    static constexpr qint64 minRunBeforeUpgradeMs = 30 * 1000;
+};
+
+
+#endif // BANDWIDTH_SCHEDULER_HPP
@@ -0,0 +1,354 @@
+#include "benchmark.hpp"
+#include "download_manager.hpp"
+#include "console_log.hpp"
+#include "queue_view.hpp"
+#include "resources/theme_engine.hpp"
+
+#include <QCommandLineParser>
+#include <QPlainTextEdit>
+#include <QGridLayout>
+#include <QPushButton>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QLabel>
+#include <QTableView>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDateTime>
+#include <QSettings>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+
+// ---------- Helper functions ----------
+static QTextStream& err()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+// user + system time of this process only, children are not included
+static qint64 cpuTimeMs()
+{
+#ifdef Q_OS_UNIX
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) { return -1; }
+    return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000
+         + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1000;
+#else
+    return -1;
+#endif
+}
+
+static qint64 peakRssKb()
+{
+#ifdef Q_OS_UNIX
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) { return -1; }
+#ifdef Q_OS_MACOS
+    return ru.ru_maxrss / 1024; // bytes on macOS
+#else
+    return ru.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+static double percentile(QVector<double> sorted, double p)
+{
+    if (sorted.isEmpty()) { return 0; }
+    int i = qBound(0, int(p * (sorted.size() - 1) + 0.5), int(sorted.size() - 1));
+    return sorted[i];
+}
+
+
+// one JSON line per run, appended to --out or printed
+static bool writeResult(const QCommandLineParser &parser, const QJsonObject &config, const QJsonObject &results)
+{
+    QJsonObject line{
+        {"timestamp", QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {"label", parser.value("label")},
+        {"qt", QString(qVersion())},
+        {"config", config},
+        {"results", results},
+    };
+    QByteArray json = QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n';
+
+    QFile f;
+    if (parser.isSet("out"))
+    {
+        f.setFileName(parser.value("out"));
+        if (!f.open(QIODevice::WriteOnly | QIODevice::Append)) { return false; }
+    }
+    else
+    {
+        f.open(stdout, QIODevice::WriteOnly);
+    }
+    return f.write(json) == json.size();
+}
+
+// switching between the built-in themes on a window-sized widget tree
+static int runThemeBenchmark(const QCommandLineParser &parser)
+{
+    int switches = qMax(2, parser.value("theme-switches").toInt());
+    ThemeEngine &engine = ThemeEngine::instance();
+
+    // rendering alone, from the parsed template and from the cache
+    QElapsedTimer t;
+    const int renders = 200;
+    t.start();
+    for (int i = 0; i < renders; i++)
+    {
+        engine.clearCache();
+        engine.render(i % 2 ? "light" : "dark");
+    }
+    double renderUs = t.nsecsElapsed() / 1e3 / renders;
+
+    t.restart();
+    for (int i = 0; i < renders; i++)
+        engine.render(i % 2 ? "light" : "dark");
+    double cachedUs = t.nsecsElapsed() / 1e3 / renders;
+
+    // roughly the window's widgets: fields, combos, buttons, console and table
+    QWidget window;
+    window.setObjectName("MainWindow");
+    QGridLayout* grid = new QGridLayout(&window);
+    for (int i = 0; i < 12; i++)
+    {
+        QPushButton* b = new QPushButton(QString("Button %1").arg(i));
+        b->setObjectName(i % 2 ? "QualityButton" : "ChooseButton");
+        grid->addWidget(b, i, 0);
+        grid->addWidget(new QLineEdit, i, 1);
+        QComboBox* c = new QComboBox;
+        c->addItems({"a", "b", "c"});
+        grid->addWidget(c, i, 2);
+        QLabel* l = new QLabel("Label");
+        l->setObjectName("Label");
+        grid->addWidget(l, i, 3);
+    }
+    grid->addWidget(new QPlainTextEdit, 12, 0, 1, 4);
+    grid->addWidget(new QTableView, 13, 0, 1, 4);
+    window.resize(1280, 720);
+    window.show();
+    QCoreApplication::processEvents();
+
+    QVector<double> switchMs;
+    for (int i = 0; i < switches; i++)
+    {
+        t.restart();
+        qApp->setStyleSheet(loadStyleSheet(i % 2 ? Theme::Light : Theme::Dark));
+        QCoreApplication::processEvents();
+        switchMs << t.nsecsElapsed() / 1e6;
+    }
+    std::sort(switchMs.begin(), switchMs.end());
+
+    QJsonObject config{
+        {"benchmark", "theme_switch"},
+        {"switches", switches},
+    };
+    QJsonObject results{
+        {"render_us", renderUs},
+        {"render_cached_us", cachedUs},
+        {"switch_p50_ms", percentile(switchMs, 0.50)},
+        {"switch_p99_ms", percentile(switchMs, 0.99)},
+        {"switch_max_ms", switchMs.last()},
+        {"stylesheet_bytes", qint64(engine.render("dark").size())},
+    };
+    return writeResult(parser, config, results) ? 0 : 2;
+}
+
+
+// ---------- entry point ----------
+int runBenchmark(QApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures output handling against a fake yt-dlp.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"bench", "Run the benchmark."},
+        {"yt-dlp", "Fake yt-dlp to run (scripts/stub-yt-dlp.sh).", "path"},
+        {"jobs", "Downloads to run (default 20).", "n", "20"},
+        {"parallel", "Downloads running at the same time (default 4).", "n", "4"},
+        {"steps", "Progress lines per download (default 200).", "n", "200"},
+        {"delay", "Seconds between progress lines (default 0).", "s", "0"},
+        {"noise-lines", "Log lines printed per progress line (default 5).", "n", "5"},
+        {"line-bytes", "Length of each log line (default 120).", "n", "120"},
+        {"limit-rate", "Bandwidth budget for all jobs, e.g. 8M (default unlimited).", "rate", "0"},
+        {"label", "Free text stored with the results, e.g. a commit id.", "text"},
+        {"out", "Append the result line to this file instead of stdout.", "file"},
+        {"theme-switches", "Time this many theme switches instead of downloads.", "n"},
+    });
+    parser.process(app);
+
+    if (parser.isSet("theme-switches"))
+        return runThemeBenchmark(parser);
+
+    QString ytDlp = parser.value("yt-dlp");
+    if (ytDlp.isEmpty() || !QFileInfo(ytDlp).isExecutable())
+    {
+        err() << "--yt-dlp must point to an executable stub" << Qt::endl;
+        return 2;
+    }
+
+    int jobCount = qMax(1, parser.value("jobs").toInt());
+    int parallel = qMax(1, parser.value("parallel").toInt());
+
+    // the stub reads its parameters from the environment it inherits
+    qputenv("STUB_STEPS", parser.value("steps").toUtf8());
+    qputenv("STUB_DELAY", parser.value("delay").toUtf8());
+    qputenv("STUB_NOISE", parser.value("noise-lines").toUtf8());
+    qputenv("STUB_LINE_BYTES", parser.value("line-bytes").toUtf8());
+    qputenv("STUB_EXIT_CODE", "0");
+
+    // nothing may touch the user's archive or download folder
+    QTemporaryDir scratch;
+    if (!scratch.isValid())
+    {
+        err() << "Could not create a temporary directory" << Qt::endl;
+        return 2;
+    }
+
+    // the user's settings would skew the numbers, so the bench runs on the
+    // defaults, read from an empty settings file, and on its own metadata cache
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, scratch.filePath("settings"));
+
+    // the user's archive and templates.json are never opened, the
+    // metadata cache is a scratch one
+    DownloadManager downloads;
+    downloads.setYtDlpPath(QFileInfo(ytDlp).absoluteFilePath());
+    downloads.archive().open(scratch.filePath("archive.txt"));
+    downloads.setThroughputLog(QString());
+    downloads.metadata()->setCacheDir(scratch.filePath("metadata"));
+    downloads.queue()->setMaxWorkers(parallel);
+
+    // the user's own budget and schedule would skew the numbers
+    BandwidthScheduler* rates = downloads.bandwidth();
+    rates->setSchedule({});
+    rates->setLimit(BandwidthScheduler::parseRate(parser.value("limit-rate")));
+
+    // every bench URL is on one host, a per-site cap would hide --parallel
+    downloads.hosts()->setMaxPerHost(0);
+
+    // same console setup as the window, rendered offscreen
+    QPlainTextEdit view;
+    view.resize(900, 600);
+    view.show();
+    ConsoleLog log(&view);
+    log.setLimits(5000, 4 * 1024 * 1024);
+
+    // and the queue table, so its per-frame updates are measured too
+    QueueView table(downloads.queue(), downloads.postProcessor());
+    table.resize(900, 400);
+    table.show();
+
+    DownloadQueue* queue = downloads.queue();
+    QObject::connect(&downloads, &DownloadManager::logLine, &log, &ConsoleLog::append);
+    QObject::connect(queue, &DownloadQueue::jobLines, &log, [&log](int id, const QStringList &lines) {
+        QString tag = QString("[#%1] ").arg(id);
+        QStringList tagged;
+        tagged.reserve(lines.size());
+        for (const QString &line : lines)
+            tagged << tag + line;
+        log.appendLines(tagged);
+    });
+
+    QElapsedTimer clock;
+    qint64 firstProgressMs = -1;
+    qint64 progressEvents = 0;
+    QObject::connect(queue, &DownloadQueue::jobProgress, [&](int, const ProgressEvent &) {
+        if (firstProgressMs < 0)
+            firstProgressMs = clock.elapsed();
+        progressEvents++;
+    });
+
+    // --- GUI thread latency ---
+    // a 10 ms timer that fires late means the event loop was busy
+    const int tickMs = 10;
+    QVector<double> lateMs;
+    qint64 lastTick = 0;
+    QTimer probe;
+    probe.setTimerType(Qt::PreciseTimer);
+    probe.setInterval(tickMs);
+    QObject::connect(&probe, &QTimer::timeout, [&] {
+        qint64 now = clock.nsecsElapsed();
+        lateMs << qMax(0.0, (now - lastTick) / 1e6 - tickMs);
+        lastTick = now;
+    });
+
+    int exitCode = 0;
+    QObject::connect(&downloads, &DownloadManager::finished, &app, [&] {
+        qint64 wallMs = qMax<qint64>(1, clock.elapsed());
+        probe.stop();
+
+        const DownloadManager::BatchStats &batch = downloads.batch();
+        std::sort(lateMs.begin(), lateMs.end());
+
+        QJsonObject config{
+            {"jobs", jobCount},
+            {"parallel", parallel},
+            {"steps", parser.value("steps").toInt()},
+            {"delay", parser.value("delay").toDouble()},
+            {"noise_lines", parser.value("noise-lines").toInt()},
+            {"line_bytes", parser.value("line-bytes").toInt()},
+            {"target_rate", rates->targetRate()},
+        };
+
+        QJsonObject results{
+            {"wall_ms", wallMs},
+            {"jobs_done", batch.done},
+            {"jobs_failed", batch.failed},
+            {"output_bytes", queue->outputBytes()},
+            {"output_lines", queue->outputLines()},
+            {"output_mib_per_s", queue->outputBytes() / 1048576.0 / (wallMs / 1000.0)},
+            {"output_lines_per_s", queue->outputLines() / (wallMs / 1000.0)},
+            {"progress_events", progressEvents},
+            {"achieved_rate", rates->totalBytes() * 1000 / wallMs},
+            {"time_to_first_progress_ms", firstProgressMs},
+            {"loop_latency_p50_ms", percentile(lateMs, 0.50)},
+            {"loop_latency_p99_ms", percentile(lateMs, 0.99)},
+            {"loop_latency_max_ms", lateMs.isEmpty() ? 0 : lateMs.last()},
+            {"gui_cpu_ms", cpuTimeMs()},
+            {"peak_rss_kb", peakRssKb()},
+            {"console_lines", log.lineCount()},
+            {"table_rows", table.model()->rowCount()},
+        };
+
+        if (!writeResult(parser, config, results))
+            exitCode = 2;
+
+        if (exitCode == 0 && batch.done != jobCount)
+            exitCode = 1;
+        app.exit(exitCode);
+    });
+
+    // --- run ---
+    DownloadRequest req;
+    req.mode = "video";
+    req.format = "mp4";
+    req.videoQuality = "Best";
+    req.outputDir = scratch.path();
+
+    clock.start();
+    probe.start();
+    for (int i = 0; i < jobCount; i++)
+    {
+        req.url = QString("https://bench.invalid/watch?v=%1").arg(i);
+        req.customName = QString("bench-%1").arg(i);
+        downloads.submit(req);
+    }
+
+    app.exec();
+    return exitCode;
+}
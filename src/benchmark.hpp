@@ -0,0 +1,13 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <QApplication>
+
+
+// "yt-dlp-GUI --bench ..." entry point: runs the download pipeline and the
+// console against a fake yt-dlp (scripts/stub-yt-dlp.sh) and prints one
+// JSON line of results, so runs on different commits can be compared.
+int runBenchmark(QApplication &app);
+
+
+#endif // BENCHMARK_HPP
@@ -0,0 +1,209 @@
+#include "console_log.hpp"
+
+#include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+
+ConsoleLog::ConsoleLog(QPlainTextEdit *view, QObject *parent)
+    : QObject(parent), view(view)
+{
+    ring.resize(5000);
+
+    frameTimer.setSingleShot(true);
+    setFrameRate(30);
+    connect(&frameTimer, &QTimer::timeout, this, &ConsoleLog::flushFrame);
+}
+
+void ConsoleLog::setLimits(int maxLines, qint64 maxBytes)
+{
+    // keeps the newest lines that fit in the new capacity
+    QStringList kept;
+    for (int i = qMax(0, count - maxLines); i < count; i++)
+        kept << ring[(head + i) % ring.size()];
+
+    ring = QVector<QString>(qMax(1, maxLines));
+    head = count = 0;
+    bytes = 0;
+    this->maxBytes = maxBytes;
+
+    for (const QString &line : kept)
+        push(line);
+
+    needsRebuild = true;
+    if (!frameTimer.isActive())
+        frameTimer.start();
+}
+
+void ConsoleLog::setFrameRate(int fps)
+{
+    frameTimer.setInterval(1000 / qBound(1, fps, 120));
+}
+
+void ConsoleLog::setSpillFile(const QString &path, qint64 rotateBytes, int keepFiles)
+{
+    if (spill.isOpen())
+        spill.close();
+
+    spillRotateBytes = rotateBytes;
+    spillKeepFiles = keepFiles;
+    if (path.isEmpty()) { return; }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    spill.setFileName(path);
+    if (!spill.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        qWarning() << "Could not open console log file:" << path;
+}
+
+void ConsoleLog::append(const QString &text)
+{
+    QString t = text;
+    if (t.endsWith('\n'))
+        t.chop(1);
+
+    appendLines(t.split('\n'));
+}
+
+void ConsoleLog::appendLines(const QStringList &lines)
+{
+    for (const QString &line : lines)
+        push(line);
+
+    pendingLines << lines;
+    if (!frameTimer.isActive())
+        frameTimer.start();
+}
+
+void ConsoleLog::clear()
+{
+    for (QString &line : ring)
+        line.clear();
+    head = count = 0;
+    bytes = 0;
+
+    // lines still waiting for a frame belong to the spill file only
+    writeSpill(pendingLines);
+    pendingLines.clear();
+    needsRebuild = false;
+
+    view->clear();
+}
+
+
+// ---------- ring buffer ----------
+void ConsoleLog::push(const QString &line)
+{
+    if (count == ring.size())
+        popOldest();
+
+    ring[(head + count) % ring.size()] = line;
+    count++;
+    bytes += line.size() * qint64(sizeof(QChar));
+
+    while (bytes > maxBytes && count > 1)
+        popOldest();
+}
+
+void ConsoleLog::popOldest()
+{
+    bytes -= ring[head].size() * qint64(sizeof(QChar));
+    ring[head].clear();
+    head = (head + 1) % ring.size();
+    count--;
+}
+
+
+// ---------- view ----------
+void ConsoleLog::flushFrame()
+{
+    writeSpill(pendingLines);
+
+    QScrollBar* sb = view->verticalScrollBar();
+    bool atBottom = sb->value() == sb->maximum();
+
+    if (needsRebuild)
+    {
+        QStringList all;
+        all.reserve(count);
+        for (int i = 0; i < count; i++)
+            all << ring[(head + i) % ring.size()];
+
+        view->setPlainText(all.join('\n'));
+        needsRebuild = false;
+    }
+    else if (!pendingLines.isEmpty())
+    {
+        // a flood may push lines out of the ring before they were ever shown
+        int fresh = qMin<int>(pendingLines.size(), count);
+        int keep = count - fresh;
+
+        QTextDocument* doc = view->document();
+        int shown = doc->isEmpty() ? 0 : doc->blockCount();
+        int drop = shown - keep;
+
+        if (drop >= shown)
+        {
+            view->clear();
+        }
+        else if (drop > 0)
+        {
+            QTextCursor c(doc);
+            c.movePosition(QTextCursor::Start);
+            c.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor, drop);
+            c.removeSelectedText();
+        }
+
+        view->appendPlainText(pendingLines.mid(pendingLines.size() - fresh).join('\n'));
+    }
+    pendingLines.clear();
+
+    if (atBottom)
+        sb->setValue(sb->maximum());
+}
+
+
+// ---------- spill file ----------
+void ConsoleLog::writeSpill(const QStringList &lines)
+{
+    if (!spill.isOpen() || lines.isEmpty()) { return; }
+
+    const QString stamp = QDateTime::currentDateTime().toString(Qt::ISODate) + " ";
+
+    QByteArray out;
+    for (const QString &line : lines)
+        out += (stamp + line).toUtf8() + '\n';
+    spill.write(out);
+    spill.flush();
+
+    if (spillRotateBytes > 0 && spill.size() >= spillRotateBytes)
+        rotateSpill();
+}
+
+void ConsoleLog::rotateSpill()
+{
+    // console.log -> console.1.log -> ... -> console.<keep>.log
+    const QString path = spill.fileName();
+    spill.close();
+
+    QFileInfo fi(path);
+    auto numbered = [&](int n) {
+        return fi.absoluteDir().filePath(fi.completeBaseName() + QString(".%1.").arg(n) + fi.suffix());
+    };
+
+    QFile::remove(numbered(spillKeepFiles));
+    for (int n = spillKeepFiles - 1; n >= 1; n--)
+        QFile::rename(numbered(n), numbered(n + 1));
+
+    if (spillKeepFiles > 0)
+        QFile::rename(path, numbered(1));
+    else
+        QFile::remove(path);
+
+    spill.setFileName(path);
+    spill.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+}
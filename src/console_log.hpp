@@ -0,0 +1,66 @@
+#ifndef CONSOLE_LOG_HPP
+#define CONSOLE_LOG_HPP
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QTimer>
+#include <QFile>
+
+class QPlainTextEdit;
+
+
+// Bounded console: lines live in a ring buffer capped by line count and
+// bytes, and the view is repainted at most once per frame with every line
+// that arrived in between. Optionally, all lines are also written to a
+// rotating file so trimming the ring never loses output.
+class ConsoleLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ConsoleLog(QPlainTextEdit *view, QObject *parent = nullptr);
+
+    void setLimits(int maxLines, qint64 maxBytes);
+    void setFrameRate(int fps);
+
+    // an empty path disables spilling
+    void setSpillFile(const QString &path, qint64 rotateBytes = 10 * 1024 * 1024, int keepFiles = 5);
+
+    void append(const QString &text);
+    void appendLines(const QStringList &lines);
+    void clear();
+
+    int lineCount() const { return count; }
+    qint64 byteCount() const { return bytes; }
+
+private:
+    QPlainTextEdit* view;
+    QTimer frameTimer;
+
+    // ring buffer
+    QVector<QString> ring;
+    int head = 0;
+    int count = 0;
+    qint64 bytes = 0;
+    qint64 maxBytes = 4 * 1024 * 1024;
+
+    // lines waiting for the next frame
+    QStringList pendingLines;
+    bool needsRebuild = false;
+
+    // spill file
+    QFile spill;
+    qint64 spillRotateBytes = 0;
+    int spillKeepFiles = 0;
+
+    void push(const QString &line);
+    void popOldest();
+    void flushFrame();
+    void writeSpill(const QStringList &lines);
+    void rotateSpill();
+};
+
+
+#endif // CONSOLE_LOG_HPP
@@ -0,0 +1,253 @@
+#include "control_server.hpp"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QUrlQuery>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QRandomGenerator>
+#include <QDebug>
+
+
+// ---------- Helper functions ----------
+static HttpResponse jsonResponse(int status, const QJsonObject &o)
+{
+    return {status, "application/json", QJsonDocument(o).toJson(QJsonDocument::Compact) + '\n'};
+}
+
+static HttpResponse errorResponse(int status, const QString &message)
+{
+    return jsonResponse(status, {{"error", message}});
+}
+
+// a body must be a JSON object; the content type also keeps browsers from
+// posting here from a web page without a CORS preflight, which is never answered
+static bool readObject(const HttpRequest &req, QJsonObject &o, HttpResponse &error)
+{
+    if (!req.headers.value("content-type").startsWith("application/json"))
+    {
+        error = errorResponse(415, "expected Content-Type: application/json");
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(req.body, &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject())
+    {
+        error = errorResponse(400, "body is not a JSON object");
+        return false;
+    }
+    o = doc.object();
+    return true;
+}
+
+
+// ---------- ControlServer ----------
+QString ControlServer::defaultTokenPath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("control_token");
+}
+
+// created on first use, readable by the current user only
+QByteArray ControlServer::loadToken(const QString &path)
+{
+    QFile f(path);
+    if (f.open(QIODevice::ReadOnly))
+    {
+        QByteArray token = f.readAll().trimmed();
+        if (!token.isEmpty()) { return token; }
+        f.close();
+    }
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Could not write control token" << path << f.errorString();
+        return {};
+    }
+    f.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner);
+
+    QByteArray random(32, Qt::Uninitialized);
+    QRandomGenerator::system()->fillRange(reinterpret_cast<quint32 *>(random.data()), random.size() / 4);
+    QByteArray token = random.toHex();
+    f.write(token + '\n');
+    return token;
+}
+
+ControlServer::ControlServer(DownloadManager *downloads, QObject *parent)
+    : QObject(parent), downloads(downloads)
+{
+    route("GET", "/jobs", [this](const HttpRequest &req) { return listJobs(req); });
+    route("POST", "/jobs", [this](const HttpRequest &req) { return submitJobs(req); });
+    route("POST", "/jobs/cancel", [this](const HttpRequest &req) { return cancelJobs(req); });
+    route("GET", "/stats", [this](const HttpRequest &req) { return stats(req); });
+}
+
+void ControlServer::route(const QByteArray &method, const QByteArray &path,
+                          std::function<HttpResponse(const HttpRequest &)> handler)
+{
+    http.addRoute(method, path, [this, handler](const HttpRequest &req) {
+        if (token.isEmpty() || req.headers.value("authorization") != "Bearer " + token)
+            return errorResponse(401, "missing or wrong token");
+        return handler(req);
+    });
+}
+
+HttpResponse ControlServer::listJobs(const HttpRequest &req) const
+{
+    QString only = QUrlQuery(QString::fromUtf8(req.query)).queryItemValue("state");
+
+    DownloadQueue* queue = downloads->queue();
+    QJsonArray list;
+    const QList<int> ids = queue->jobIds();
+    for (int id : ids)
+    {
+        const DownloadJob* j = queue->job(id);
+        if (!j) { continue; }
+
+        // a failed job that is about to be tried again is not done yet
+        QString state = downloads->retries()->isWaiting(id) ? "retrying" : jobStateName(j->state);
+        if (!only.isEmpty() && state != only) { continue; }
+
+        QJsonObject o{
+            {"id", id},
+            {"url", j->url},
+            {"state", state},
+            {"site", HostScheduler::siteOf(j->url)},
+        };
+        if (j->state == JobState::Running)
+        {
+            o.insert("percent", j->progress.percent());
+            o.insert("speed", j->progress.speed);
+            o.insert("eta", j->progress.eta);
+        }
+        if (j->progress.totalBytes >= 0)
+            o.insert("total_bytes", j->progress.totalBytes);
+        if (j->exitCode >= 0)
+            o.insert("exit_code", j->exitCode);
+        list << o;
+    }
+    return jsonResponse(200, {{"jobs", list}});
+}
+
+HttpResponse ControlServer::submitJobs(const HttpRequest &req)
+{
+    QJsonObject body;
+    HttpResponse error;
+    if (!readObject(req, body, error)) { return error; }
+
+    QStringList urls;
+    if (body.contains("url"))
+        urls << body.value("url").toString();
+    for (const QJsonValue &v : body.value("urls").toArray())
+        urls << v.toString();
+    if (urls.isEmpty())
+        return errorResponse(400, "no \"url\" or \"urls\" given");
+
+    DownloadRequest base;
+    QString reason;
+    if (defaults && !defaults(base, reason))
+        return errorResponse(409, reason);
+
+    // per-submission options override the window's, e.g. {"mode": "audio"};
+    // nothing that reaches yt-dlp's command line unchecked (-o, -f, cookies)
+    const QJsonObject options = body.value("options").toObject();
+    QJsonObject allowed;
+    for (const char *key : {"mode", "format", "quality", "dir"})
+        if (options.contains(key)) { allowed.insert(key, options.value(key)); }
+    for (auto it = options.constBegin(); it != options.constEnd(); ++it)
+        if (!allowed.contains(it.key()))
+            return errorResponse(400, "option \"" + it.key() + "\" is not accepted here");
+
+    base = DownloadRequest::fromJson(allowed, base);
+    base.url.clear();
+    base.customName.clear();
+    if (base.mode != "video" && base.mode != "audio")
+        return errorResponse(400, "mode must be video or audio");
+    QStringList formats = base.isAudio() ? QStringList{"mp3", "opus"} : QStringList{"mp4", "mkv"};
+    if (!formats.contains(base.format))
+        return errorResponse(400, "format must be one of " + formats.join(", "));
+    if (base.outputDir.isEmpty())
+        return errorResponse(409, "no destination directory");
+    if (!QDir().mkpath(base.outputDir))
+        return errorResponse(409, "could not create " + base.outputDir);
+
+    emit submitting();
+    DownloadManager::IngestStats r = downloads->submitUrls(base, urls);
+    emit submitted(r);
+
+    return jsonResponse(r.accepted > 0 ? 202 : 200, {
+        {"accepted", r.accepted},
+        {"duplicates", r.duplicates},
+        {"archived", r.archived},
+        {"invalid", r.invalid},
+    });
+}
+
+HttpResponse ControlServer::cancelJobs(const HttpRequest &req)
+{
+    QJsonObject body;
+    HttpResponse error;
+    if (!readObject(req, body, error)) { return error; }
+
+    if (body.value("all").toBool())
+    {
+        downloads->cancelAll();
+        emit canceled({});
+        return jsonResponse(200, {{"canceled", "all"}});
+    }
+
+    QList<int> ids;
+    if (body.contains("id"))
+        ids << body.value("id").toInt();
+    for (const QJsonValue &v : body.value("ids").toArray())
+        ids << v.toInt();
+    if (ids.isEmpty())
+        return errorResponse(400, "no \"id\", \"ids\" or \"all\" given");
+
+    QJsonArray done;
+    QJsonArray skipped;
+    QList<int> canceledIds;
+    for (int id : std::as_const(ids))
+    {
+        if (downloads->cancel(id))
+        {
+            done << id;
+            canceledIds << id;
+        }
+        else
+        {
+            skipped << id;
+        }
+    }
+    if (!canceledIds.isEmpty())
+        emit canceled(canceledIds);
+
+    // skipped: unknown, or already finished, failed or converting
+    return jsonResponse(200, {{"canceled", done}, {"skipped", skipped}});
+}
+
+HttpResponse ControlServer::stats(const HttpRequest &) const
+{
+    const DownloadManager::BatchStats &batch = downloads->batch();
+    MetricsSample now = downloads->metrics()->latest();
+
+    return jsonResponse(200, {
+        {"idle", downloads->isIdle()},
+        {"running", downloads->queue()->runningCount()},
+        {"pending", downloads->queue()->pendingCount()},
+        {"converting", now.converting},
+        {"bytes_per_sec", now.bytesPerSec},
+        {"bytes_total", now.bytesTotal},
+        {"rate_limit", downloads->bandwidth()->limit()},
+        {"batch", QJsonObject{
+            {"total", batch.total},
+            {"done", batch.done},
+            {"failed", batch.failed},
+            {"canceled", batch.canceled},
+        }},
+    });
+}
@@ -0,0 +1,65 @@
+#ifndef CONTROL_SERVER_HPP
+#define CONTROL_SERVER_HPP
+
+#include "download_manager.hpp"
+#include "local_http_server.hpp"
+#include <QObject>
+#include <functional>
+
+
+// JSON API on 127.0.0.1 for scripts driving a running instance:
+//   GET  /jobs[?state=running]   every job of the session
+//   POST /jobs                   {"urls": [...], "options": {"mode", "format", "quality", "dir"}}
+//   POST /jobs/cancel            {"ids": [...]} or {"all": true}
+//   GET  /stats                  batch counters and current rate
+// Submissions go through DownloadManager::submitUrls, so they are deduped
+// and queued a chunk per event loop turn like pasted URLs; no handler
+// blocks on a download.
+class ControlServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // fills in the options a submission starts from, or says why jobs
+    // cannot be taken right now; called before the request is validated,
+    // so it must not change anything
+    using Defaults = std::function<bool(DownloadRequest &req, QString &error)>;
+
+    explicit ControlServer(DownloadManager *downloads, QObject *parent = nullptr);
+
+    void setDefaults(Defaults f) { defaults = std::move(f); }
+
+    // every request needs "Authorization: Bearer <token>"; without one
+    // the server refuses everything
+    void setToken(const QByteArray &t) { token = t; }
+
+    // the token in path, generated there on first use
+    static QByteArray loadToken(const QString &path);
+    static QString defaultTokenPath();
+
+    bool listen(quint16 port) { return http.listen(port); }
+    quint16 port() const { return http.port(); }
+
+signals:
+    // a valid submission is about to be queued
+    void submitting();
+    void submitted(const DownloadManager::IngestStats &stats);
+    void canceled(const QList<int> &ids);
+
+private:
+    DownloadManager* downloads;
+    LocalHttpServer http;
+    Defaults defaults;
+    QByteArray token;
+
+    void route(const QByteArray &method, const QByteArray &path,
+               std::function<HttpResponse(const HttpRequest &)> handler);
+
+    HttpResponse listJobs(const HttpRequest &req) const;
+    HttpResponse submitJobs(const HttpRequest &req);
+    HttpResponse cancelJobs(const HttpRequest &req);
+    HttpResponse stats(const HttpRequest &req) const;
+};
+
+
+#endif // CONTROL_SERVER_HPP
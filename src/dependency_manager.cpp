@@ -0,0 +1,203 @@
+#include "dependency_manager.hpp"
+
+#include <QProcess>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSettings>
+#include <QTimer>
+
+
+// ---------- Helper functions ----------
+static QString firstLine(const QByteArray &out)
+{
+    return QString::fromLocal8Bit(out).section('\n', 0, 0).trimmed();
+}
+
+// "ffmpeg version 7.0.1-static https://... Copyright ..."
+static QString ffmpegVersion(const QByteArray &out)
+{
+    return firstLine(out).section(' ', 2, 2);
+}
+
+// " V....D libx264   libx264 H.264 / ..." after a " ------" separator
+static QStringList ffmpegEncoders(const QByteArray &out)
+{
+    QStringList names;
+    bool listing = false;
+
+    const QList<QByteArray> lines = out.split('\n');
+    for (const QByteArray &raw : lines)
+    {
+        QByteArray line = raw.trimmed();
+        if (!listing)
+        {
+            listing = line.startsWith("------");
+            continue;
+        }
+
+        QList<QByteArray> cols = line.simplified().split(' ');
+        if (cols.size() >= 2)
+            names << QString::fromLatin1(cols[1]);
+    }
+    return names;
+}
+
+// "Hardware acceleration methods:" followed by one name per line
+static QStringList ffmpegHwaccels(const QByteArray &out)
+{
+    QStringList names;
+    const QList<QByteArray> lines = out.split('\n');
+    for (int i = 1; i < lines.size(); i++)
+    {
+        QString name = QString::fromLatin1(lines[i].trimmed());
+        if (!name.isEmpty())
+            names << name;
+    }
+    return names;
+}
+
+
+// ---------- DependencyManager ----------
+DependencyManager::DependencyManager(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void DependencyManager::setPaths(const QString &ytDlpPath, const QString &ffmpegPath)
+{
+    if (ytDlpPath == ytDlpInfo.path && ffmpegPath == ffmpegInfo.path) { return; }
+
+    ytDlpInfo = ToolInfo();
+    ytDlpInfo.path = ytDlpPath;
+    ffmpegInfo = ToolInfo();
+    ffmpegInfo.path = ffmpegPath;
+    checked = false;
+}
+
+void DependencyManager::check()
+{
+    // results of an older check are dropped when they arrive
+    int gen = ++generation;
+    probes = 0;
+
+    ytDlpInfo = stat(ytDlpInfo.path);
+    ffmpegInfo = stat(ffmpegInfo.path);
+    checked = true;
+
+    if (ytDlpInfo.usable() && !loadCached("dependency_cache/yt_dlp", ytDlpInfo))
+    {
+        probe(ytDlpInfo.path, {"--version"}, [=](const QByteArray &out) {
+            ytDlpInfo.version = firstLine(out);
+        });
+    }
+
+    if (ffmpegInfo.usable() && !loadCached("dependency_cache/ffmpeg", ffmpegInfo))
+    {
+        probe(ffmpegInfo.path, {"-hide_banner", "-version"}, [=](const QByteArray &out) {
+            ffmpegInfo.version = ffmpegVersion(out);
+        });
+        probe(ffmpegInfo.path, {"-hide_banner", "-encoders"}, [=](const QByteArray &out) {
+            ffmpegInfo.encoders = ffmpegEncoders(out);
+        });
+        probe(ffmpegInfo.path, {"-hide_banner", "-hwaccels"}, [=](const QByteArray &out) {
+            ffmpegInfo.hwaccels = ffmpegHwaccels(out);
+        });
+    }
+
+    // everything came from the cache
+    if (probes == 0)
+        QTimer::singleShot(0, this, [=] {
+            if (gen == generation)
+                emit ready();
+        });
+}
+
+ToolInfo DependencyManager::stat(const QString &path)
+{
+    ToolInfo info;
+    info.path = path;
+
+    QFileInfo fi(path);
+    info.executable = fi.exists() && fi.isFile() && fi.isExecutable();
+    if (info.executable)
+    {
+        info.size = fi.size();
+        info.modified = fi.lastModified().toSecsSinceEpoch();
+    }
+    return info;
+}
+
+bool DependencyManager::loadCached(const QString &group, ToolInfo &info)
+{
+    QSettings s;
+    s.beginGroup(group);
+
+    // a replaced or updated binary has a different size or mtime
+    if (s.value("path").toString() != info.path
+        || s.value("size").toLongLong() != info.size
+        || s.value("modified").toLongLong() != info.modified)
+    {
+        return false;
+    }
+
+    info.version = s.value("version").toString();
+    info.encoders = s.value("encoders").toStringList();
+    info.hwaccels = s.value("hwaccels").toStringList();
+    return !info.version.isEmpty();
+}
+
+void DependencyManager::storeCached(const QString &group, const ToolInfo &info)
+{
+    if (info.version.isEmpty()) { return; }
+
+    QSettings s;
+    s.beginGroup(group);
+    s.setValue("path", info.path);
+    s.setValue("size", info.size);
+    s.setValue("modified", info.modified);
+    s.setValue("version", info.version);
+    s.setValue("encoders", info.encoders);
+    s.setValue("hwaccels", info.hwaccels);
+}
+
+
+// ---------- probing ----------
+void DependencyManager::probe(const QString &program, const QStringList &args,
+                              std::function<void(const QByteArray &)> done)
+{
+    probes++;
+    int gen = generation;
+
+    QProcess* p = new QProcess(this);
+    p->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(p, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+        this,
+        [=](int code, QProcess::ExitStatus status) {
+            p->deleteLater();
+            if (gen != generation) { return; }
+
+            if (status == QProcess::NormalExit && code == 0)
+                done(p->readAll());
+            probeFinished();
+        });
+
+    // finished() is never emitted when the binary cannot be launched
+    connect(p, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) { return; }
+        p->deleteLater();
+        if (gen == generation)
+            probeFinished();
+    });
+
+    p->start(program, args);
+}
+
+void DependencyManager::probeFinished()
+{
+    if (--probes > 0) { return; }
+
+    storeCached("dependency_cache/yt_dlp", ytDlpInfo);
+    storeCached("dependency_cache/ffmpeg", ffmpegInfo);
+    emit ready();
+}
@@ -0,0 +1,71 @@
+#ifndef DEPENDENCY_MANAGER_HPP
+#define DEPENDENCY_MANAGER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <functional>
+
+
+struct ToolInfo
+{
+    QString path;
+    bool executable = false;
+    qint64 size = 0;
+    qint64 modified = 0;
+
+    // empty until the probe has run (or the binary is unusable)
+    QString version;
+    QStringList encoders;
+    QStringList hwaccels;
+
+    bool usable() const { return executable; }
+};
+
+// Validates yt-dlp and ffmpeg once, in the background: a stat of each
+// binary, then "--version" and ffmpeg's encoders and hwaccels. Results
+// are kept in QSettings keyed on path, size and mtime, so an unchanged
+// binary is never probed again and the download path just reads them.
+class DependencyManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DependencyManager(QObject *parent = nullptr);
+
+    void setPaths(const QString &ytDlpPath, const QString &ffmpegPath);
+
+    // stats both binaries now, probes them asynchronously when not cached
+    void check();
+    bool isChecked() const { return checked; }
+    bool isProbing() const { return probes > 0; }
+
+    const ToolInfo& ytDlp() const { return ytDlpInfo; }
+    const ToolInfo& ffmpeg() const { return ffmpegInfo; }
+
+    bool hasEncoder(const QString &name) const { return ffmpegInfo.encoders.contains(name); }
+    bool hasHwaccel(const QString &name) const { return ffmpegInfo.hwaccels.contains(name); }
+
+signals:
+    // versions and capabilities are known (or known to be missing)
+    void ready();
+
+private:
+    ToolInfo ytDlpInfo;
+    ToolInfo ffmpegInfo;
+    bool checked = false;
+    int probes = 0;
+    int generation = 0;
+
+    static ToolInfo stat(const QString &path);
+    static bool loadCached(const QString &group, ToolInfo &info);
+    static void storeCached(const QString &group, const ToolInfo &info);
+
+    void probe(const QString &program, const QStringList &args,
+               std::function<void(const QByteArray &)> done);
+    void probeFinished();
+};
+
+
+#endif // DEPENDENCY_MANAGER_HPP
@@ -0,0 +1,110 @@
+#include "download_archive.hpp"
+
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+
+QString DownloadArchive::key(const QString &extractor, const QString &id)
+{
+    return extractor.toLower() + " " + id;
+}
+
+bool DownloadArchive::open(const QString &path)
+{
+    if (file.isOpen())
+        file.close();
+
+    filePath = path;
+    entries.clear();
+    fileLines = 0;
+
+    QFile in(path);
+    if (in.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        while (!in.atEnd())
+        {
+            QByteArray line = in.readLine().trimmed();
+            fileLines++;
+
+            // a torn last line after a crash has no id
+            if (line.indexOf(' ') <= 0) { continue; }
+            entries.insert(QString::fromUtf8(line));
+        }
+        in.close();
+    }
+
+    if (needsCompaction())
+        compact();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    file.setFileName(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+    {
+        qWarning() << "Could not open download archive:" << path;
+        return false;
+    }
+
+    return true;
+}
+
+bool DownloadArchive::contains(const QString &extractor, const QString &id) const
+{
+    if (extractor.isEmpty() || id.isEmpty()) { return false; }
+    return entries.contains(key(extractor, id));
+}
+
+bool DownloadArchive::record(const QString &extractor, const QString &id)
+{
+    if (extractor.isEmpty() || id.isEmpty()) { return false; }
+
+    QString k = key(extractor, id);
+    if (entries.contains(k)) { return true; }
+    if (!file.isOpen()) { return false; }
+
+    // one write per entry, so a crash can at worst leave a torn last line
+    QByteArray line = k.toUtf8() + '\n';
+    if (file.write(line) != line.size() || !file.flush())
+        return false;
+
+    entries.insert(k);
+    fileLines++;
+
+    if (needsCompaction())
+        compact();
+
+    return true;
+}
+
+bool DownloadArchive::needsCompaction() const
+{
+    return fileLines > entries.size() + qMax(1000, entries.size() / 4);
+}
+
+bool DownloadArchive::compact()
+{
+    if (filePath.isEmpty()) { return false; }
+
+    // written aside and renamed over the old file
+    QSaveFile out(filePath);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Text)) { return false; }
+
+    QByteArray data;
+    for (const QString &k : entries)
+        data += k.toUtf8() + '\n';
+    out.write(data);
+
+    bool reopen = file.isOpen();
+    if (reopen)
+        file.close();
+
+    bool ok = out.commit();
+    if (ok)
+        fileLines = entries.size();
+
+    if (reopen)
+        file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+
+    return ok;
+}
@@ -0,0 +1,36 @@
+#ifndef DOWNLOAD_ARCHIVE_HPP
+#define DOWNLOAD_ARCHIVE_HPP
+
+#include <QString>
+#include <QSet>
+#include <QFile>
+
+
+// Same format as yt-dlp's --download-archive ("<extractor> <id>" per line),
+// held in a hash set so lookups never touch the disk. The file is only
+// ever appended to; duplicates and junk are dropped by compact().
+class DownloadArchive
+{
+public:
+    bool open(const QString &path);
+    QString path() const { return filePath; }
+
+    bool contains(const QString &extractor, const QString &id) const;
+    bool record(const QString &extractor, const QString &id);
+
+    int size() const { return entries.size(); }
+    bool compact();
+
+    static QString key(const QString &extractor, const QString &id);
+
+private:
+    QString filePath;
+    QSet<QString> entries;
+    QFile file;
+    int fileLines = 0;
+
+    bool needsCompaction() const;
+};
+
+
+#endif // DOWNLOAD_ARCHIVE_HPP
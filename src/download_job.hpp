@@ -0,0 +1,49 @@
+#ifndef DOWNLOAD_JOB_HPP
+#define DOWNLOAD_JOB_HPP
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include "progress_parser.hpp"
+
+
+enum class JobState {
+    Queued,
+    Running,
+    Finished,
+    Failed,
+    Canceled
+};
+
+struct DownloadJob
+{
+    int id = 0;
+    QString url;
+    QStringList args;
+
+    // filled from metadata when known up front, otherwise from progress lines
+    QString extractor;
+    QString videoId;
+
+    JobState state = JobState::Queued;
+    int exitCode = -1;
+
+    // latest progress line and the tail of every other line yt-dlp printed
+    ProgressEvent progress;
+    QByteArray output;
+
+    // wall clock in ms since epoch, 0 until it happened, and the bytes
+    // actually transferred (resumed .part data is not counted again)
+    qint64 startedAt = 0;
+    qint64 finishedAt = 0;
+    qint64 receivedBytes = 0;
+
+    // files yt-dlp said it is writing (media and thumbnails), their
+    // leftovers are removed on cancel
+    QStringList destinations;
+};
+
+QString jobStateName(JobState state);
+
+
+#endif // DOWNLOAD_JOB_HPP
@@ -0,0 +1,751 @@
+#include "download_manager.hpp"
+
+#include <QCoreApplication>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFileInfo>
+#include <QDebug>
+#include <QThread>
+#include <QDateTime>
+#include <QUuid>
+#include <utility>
+
+
+DownloadManager::DownloadManager(QObject *parent)
+    : QObject(parent)
+{
+    QSettings settings;
+
+    jobs = new DownloadQueue(this);
+    jobs->setMaxWorkers(settings.value("max_parallel_downloads", 3).toInt());
+
+    // --- metadata prefetch ---
+    meta = new MetadataService(this);
+    meta->setCacheDir(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("metadata"));
+    meta->setTtl(settings.value("metadata_ttl_hours", 6).toLongLong() * 60 * 60);
+
+    // --- playlist fan-out ---
+    playlists = new PlaylistExpander(this);
+
+    connect(playlists, &PlaylistExpander::expanded, this, &DownloadManager::playlistExpanded);
+    connect(playlists, &PlaylistExpander::failed, this, &DownloadManager::playlistFailed);
+
+    // --- global bandwidth budget ---
+    rates = new BandwidthScheduler(jobs, this);
+    rates->setLimit(BandwidthScheduler::parseRate(settings.value("bandwidth_limit").toString()));
+
+    QList<BandwidthRule> rules;
+    if (BandwidthScheduler::parseSchedule(settings.value("bandwidth_schedule").toString(), rules))
+        rates->setSchedule(rules);
+    else
+        qWarning() << "Ignoring malformed bandwidth_schedule:" << settings.value("bandwidth_schedule").toString();
+
+    // --- per-site caps and pacing ---
+    sites = new HostScheduler(jobs, this);
+    sites->setMaxPerHost(settings.value("max_per_host", 2).toInt());
+
+    connect(sites, &HostScheduler::throttled, this, [this](const QString &site, int level) {
+        emit logLine(QString("%1 is throttling (HTTP 429), pacing its requests (level %2) and running one job at a time")
+                         .arg(site).arg(level));
+    });
+    connect(sites, &HostScheduler::recovered, this, [this](const QString &site) {
+        emit logLine(QString("%1 is no longer throttled").arg(site));
+    });
+
+    // --- free space and scratch directory ---
+    disks = new StorageManager(jobs, this);
+    disks->setMinFree(settings.value("min_free_space_mb", 512).toLongLong() * 1024 * 1024);
+    disks->setScratchDir(settings.value("temp_dir").toString());
+
+    connect(disks, &StorageManager::held, this, [this](const QString &volume, int id, qint64 needed, qint64 available) {
+        emit logLine(QString("[#%1] waiting for disk space on %2: needs %3, %4 available")
+                         .arg(id).arg(volume, formatBytes(needed), formatBytes(available)));
+    });
+    connect(disks, &StorageManager::scratchSkipped, this, [this](const QString &dir, const QString &scratch) {
+        emit logLine(QString("%1 is on another drive than %2, writing there directly").arg(scratch, dir));
+    });
+
+    // --- fragment concurrency, bounded across all workers ---
+    maxConnections = qMax(1, settings.value("max_connections", 16).toInt());
+    jobs->addLaunchArgs([this](int id) { return fragmentArgs(id); });
+
+    if (settings.value("throughput_log_enabled", true).toBool())
+    {
+        QString logDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+        throughputLog.setFileName(settings.value("throughput_log", QDir(logDir).filePath("throughput.csv")).toString());
+    }
+
+    // --- conversions run in their own ffmpeg pool, sized to the CPU ---
+    post = new PostProcessor(this);
+    post->setMaxWorkers(settings.value("postprocess_workers", QThread::idealThreadCount()).toInt());
+    separatePostProcessing = settings.value("separate_postprocessing", true).toBool();
+    loudnorm = settings.value("loudness_normalize", false).toBool();
+    transcode = TranscodeSettings::fromSettings();
+
+    connect(post, &PostProcessor::taskStarted, this, [this](int id) {
+        emit logLine(QString("[#%1] converting...").arg(id));
+    });
+    connect(post, &PostProcessor::taskFinished, this, &DownloadManager::postProcessed);
+
+    // --- transient failures are retried after a backoff ---
+    retry = new RetryScheduler(jobs, this);
+    retry->setPolicy(RetryPolicy::fromSettings());
+
+    connect(retry, &RetryScheduler::retryScheduled, this, [this](int id, int attempt, int delayMs, const Failure &f) {
+        emit logLine(QString("[#%1] %2, retry %3/%4 in %5 s")
+                         .arg(id).arg(f.kindName()).arg(attempt).arg(retry->policy().maxAttempts)
+                         .arg(qRound(delayMs / 1000.0)));
+    });
+    connect(retry, &RetryScheduler::retryStarted, this, [this](int id) {
+        emit logLine(QString("[#%1] retrying").arg(id));
+    });
+
+    // --- yt-dlp / ffmpeg validation, started by the caller ---
+    deps = new DependencyManager(this);
+
+    connect(jobs, &DownloadQueue::jobFinished, this, &DownloadManager::jobFinished);
+    connect(jobs, &DownloadQueue::idle, this, &DownloadManager::checkFinished);
+
+    backlogTimer.setInterval(0);
+    connect(&backlogTimer, &QTimer::timeout, this, &DownloadManager::drainBacklog);
+
+    // --- per-job metrics, connected last so it sees post-processing already queued ---
+    recorder = new MetricsRecorder(jobs, post, this);
+
+    setDepsDir(defaultDepsDir());
+}
+
+void DownloadManager::openArchive()
+{
+    QSettings settings;
+    if (!settings.value("download_archive_enabled", true).toBool()) { return; }
+
+    QString archivePath = settings.value("download_archive",
+        QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("archive.txt")).toString();
+    history.open(archivePath);
+}
+
+void DownloadManager::loadTemplates()
+{
+    templates.load(OutputTemplates::defaultPath());
+
+    QSettings settings;
+    if (settings.contains("output_template"))
+        templates.setDefaultPattern(settings.value("output_template").toString());
+}
+
+QString DownloadManager::defaultDepsDir()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath("deps");
+}
+
+void DownloadManager::setDepsDir(const QString &dir)
+{
+#ifdef Q_OS_WIN
+    ytDlp = QDir(dir).filePath("yt-dlp.exe");
+    ffmpeg = QDir(dir).filePath("ffmpeg.exe");
+#else
+    ytDlp = QDir(dir).filePath("yt-dlp");
+    ffmpeg = QDir(dir).filePath("ffmpeg");
+#endif
+
+    post->setProgram(ffmpeg);
+    setYtDlpPath(ytDlp);
+}
+
+void DownloadManager::setYtDlpPath(const QString &path)
+{
+    ytDlp = path;
+    jobs->setProgram(ytDlp);
+    meta->setProgram(ytDlp);
+    playlists->setProgram(ytDlp);
+    deps->setPaths(ytDlp, ffmpeg);
+}
+
+void DownloadManager::setThroughputLog(const QString &path)
+{
+    throughputLog.close();
+    throughputLog.setFileName(path);
+}
+
+QString DownloadManager::defaultJournalPath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).filePath("journal.jsonl");
+}
+
+bool DownloadManager::openJournal(const QString &path)
+{
+    if (journal) { return true; }
+
+    journal = new JobJournal(this);
+    if (!journal->open(path))
+    {
+        delete journal;
+        journal = nullptr;
+        return false;
+    }
+
+    connect(jobs, &DownloadQueue::jobStarted, this, [this](int id) {
+        journal->started(jobUids.value(id));
+    });
+    connect(jobs, &DownloadQueue::jobProgress, this, [this](int id) {
+        if (const DownloadJob* j = jobs->job(id))
+            journal->checkpoint(jobUids.value(id), j->receivedBytes);
+    });
+    connect(jobs, &DownloadQueue::jobFinished, this, [this](int id, int, JobState state) {
+        // still owed a retry, so still unfinished if the app goes down now
+        if (retry->isWaiting(id)) { return; }
+        // the conversion still has to run, postProcessed() closes the entry;
+        // startPostProcessing() already closed it when there was nothing to convert
+        if (post->isQueued(id) || awaitingPost.contains(id) || !jobUids.contains(id)) { return; }
+        journal->finished(jobUids.take(id), jobStateName(state));
+    });
+
+    return true;
+}
+
+int DownloadManager::resumeInterrupted()
+{
+    if (!journal) { return 0; }
+
+    int resumed = 0;
+    const QList<JournalEntry> entries = journal->interrupted();
+    for (const JournalEntry &e : entries)
+    {
+        DownloadRequest req = DownloadRequest::fromJson(e.request, DownloadRequest());
+        req.resume = true;
+
+        // journaled again under a new uid by enqueueRequest()
+        journal->finished(e.uid, "resumed");
+
+        if (req.url.isEmpty()) { continue; }
+        if (e.started)
+            emit logLine(QString("Resuming interrupted download (%1 received): %2").arg(formatBytes(e.bytes), req.url));
+        if (enqueueRequest(req))
+            resumed++;
+    }
+    return resumed;
+}
+
+void DownloadManager::resetBatch()
+{
+    stats = BatchStats();
+    emit batchChanged();
+}
+
+void DownloadManager::cancelAll()
+{
+    pendingPlaylists.clear();
+
+    // not queued yet, so they may be pasted again
+    for (const DownloadRequest &req : std::as_const(backlog))
+        knownUrls.remove(canonicalizeUrl(req.url).key());
+    backlog.clear();
+    backlogTimer.stop();
+
+    // failed jobs waiting for a retry are not in the queue any more
+    const QList<int> waiting = retry->cancelAll();
+    for (int id : waiting)
+        dropWaitingRetry(id);
+    if (!waiting.isEmpty())
+        emit batchChanged();
+
+    jobs->cancelAll();
+    post->cancelAll();
+    checkFinished();
+}
+
+bool DownloadManager::cancel(int id)
+{
+    if (retry->isWaiting(id))
+    {
+        retry->forget(id);
+        dropWaitingRetry(id);
+        emit batchChanged();
+        checkFinished();
+        return true;
+    }
+
+    // jobs in the post-processing stage are left to finish
+    const DownloadJob* j = jobs->job(id);
+    if (!j || (j->state != JobState::Queued && j->state != JobState::Running)) { return false; }
+
+    jobs->cancel(id);
+    return true;
+}
+
+void DownloadManager::dropWaitingRetry(int id)
+{
+    stats.canceled++;
+    releaseOutputName(id);
+    knownUrls.remove(jobKeys.take(id));
+    awaitingPost.remove(id);
+    plans.remove(id);
+    autoFragmentJobs.remove(id);
+    jobFragments.remove(id);
+    if (journal)
+        journal->finished(jobUids.take(id), "canceled");
+}
+
+
+// ---------- submitting ----------
+void DownloadManager::submit(const DownloadRequest &req)
+{
+    // playlists are listed first and fanned out into one job per entry
+    if (isPlaylistUrl(req.url) && !req.noPlaylist && req.outputTemplate.isEmpty())
+    {
+        emit logLine("Listing playlist: " + req.url);
+        pendingPlaylists.insert(req.url, req);
+
+        QStringList extraArgs;
+        if (!req.cookiesBrowser.isEmpty())
+            extraArgs << "--cookies-from-browser" << req.cookiesBrowser;
+        playlists->expand(req.url, extraArgs);
+        return;
+    }
+
+    enqueueRequest(req);
+}
+
+DownloadManager::IngestStats DownloadManager::submitUrls(const DownloadRequest &base, const QStringList &urls)
+{
+    IngestStats result;
+    for (const QString &text : urls)
+    {
+        CanonicalUrl c = canonicalizeUrl(text);
+        if (!c.isValid())
+        {
+            result.invalid++;
+            continue;
+        }
+
+        QString key = c.key();
+        if (knownUrls.contains(key))
+        {
+            result.duplicates++;
+            continue;
+        }
+        if (!c.id.isEmpty() && history.contains(c.extractor, c.id))
+        {
+            result.archived++;
+            continue;
+        }
+
+        knownUrls.insert(key);
+        DownloadRequest req = base;
+        req.url = c.url;
+        backlog << req;
+        result.accepted++;
+    }
+
+    if (!backlog.isEmpty())
+        backlogTimer.start();
+    return result;
+}
+
+void DownloadManager::drainBacklog()
+{
+    int n = qMin(backlogChunk, int(backlog.size()));
+    const QList<DownloadRequest> chunk = backlog.mid(0, n);
+    backlog.remove(0, n);
+
+    for (const DownloadRequest &req : chunk)
+        submit(req);
+
+    if (backlog.isEmpty())
+    {
+        backlogTimer.stop();
+        checkFinished();
+    }
+}
+
+// the exact name when it can be known up front (a custom name, or the
+// template expanded from cached metadata), reserved in the name index;
+// otherwise yt-dlp fills in the template and the name is indexed later
+DownloadManager::ReservedName DownloadManager::assignOutputName(DownloadRequest &req, const VideoMetadata &md)
+{
+    // playlist entries are numbered in their own folder, and journaled jobs
+    // keep the name they had so their .part files are found again
+    if (!req.outputTemplate.isEmpty())
+    {
+        QString t = req.outputTemplate;
+        if (t.endsWith(".%(ext)s") && !t.chopped(8).contains("%("))
+        {
+            QFileInfo fi(t.chopped(8).replace("%%", "%"));
+            fileNames.claim(fi.absolutePath(), fi.fileName());
+        }
+        return {};
+    }
+    if (isPlaylistUrl(req.url) && !req.noPlaylist) { return {}; }
+
+    QString pattern = templates.patternFor(req.url, req.mode);
+    QStringList parts;
+    if (!req.customName.isEmpty())
+        parts << req.customName;
+    else if (md.isValid())
+        parts = OutputTemplates::expand(pattern, md, req);
+    else
+    {
+        req.outputTemplate = req.outputDir + "/" + OutputTemplates::toYtDlp(pattern, req) + ".%(ext)s";
+        return {};
+    }
+
+    QString base = parts.takeLast();
+    QString dir = parts.isEmpty() ? req.outputDir : req.outputDir + "/" + parts.join('/');
+    QString name = fileNames.reserve(dir, base, req.format);
+
+    req.outputTemplate = dir + "/" + QString(name).replace('%', "%%") + ".%(ext)s";
+    return {dir, name};
+}
+
+void DownloadManager::releaseOutputName(int id)
+{
+    unnamedJobs.remove(id);
+
+    auto it = jobNames.find(id);
+    if (it == jobNames.end()) { return; }
+    fileNames.release(it->dir, it->name);
+    jobNames.erase(it);
+}
+
+bool DownloadManager::enqueueRequest(DownloadRequest req, const QString &extractor, const QString &videoId)
+{
+    VideoMetadata md;
+    TranscodePlan plan;
+    bool planned = false;
+    QString knownExtractor = extractor;
+    QString knownId = videoId;
+    if (meta->lookup(req.url, md))
+    {
+        // the formats to fetch are picked so the output needs as little work as possible
+        plan = req.isAudio()
+            ? planAudio(md, req.format, req.audioQuality, loudnorm)
+            : planVideo(md, req.maxHeight(), req.format);
+        req.exactFormat = plan.formatId;
+        planned = !plan.formatId.isEmpty();
+
+        knownExtractor = md.extractor;
+        knownId = md.id;
+    }
+
+    // already fetched once, no need to even start yt-dlp
+    if (history.contains(knownExtractor, knownId))
+    {
+        emit logLine("Skipping (already in download archive): " + req.url);
+        return false;
+    }
+
+    req.rawAudio = req.isAudio() && separatePostProcessing;
+    req.tempDir = disks->tempDirFor(req.outputDir);
+    ReservedName name = assignOutputName(req, md);
+    QStringList args = buildYtDlpArgs(req, ffmpeg);
+
+    // known before enqueue(), which may start it right away
+    disks->track(jobs->nextJobId(), req.outputDir, planned ? StorageManager::peakBytes(md, plan.formatId, req.isAudio()) : 0);
+    int id = jobs->enqueue(req.url, args, knownExtractor, knownId);
+    if (!name.name.isEmpty())
+        jobNames.insert(id, name);
+    else
+        unnamedJobs.insert(id);
+
+    QString key = canonicalizeUrl(req.url).key();
+    knownUrls.insert(key);
+    jobKeys.insert(id, key);
+    if (journal)
+    {
+        QString uid = QUuid::createUuid().toString(QUuid::WithoutBraces);
+        jobUids.insert(id, uid);
+        journal->enqueued(uid, req.toJson());
+
+        // enqueue() may have started it before the uid was known
+        if (jobs->job(id)->state == JobState::Running)
+            journal->started(uid);
+    }
+    if (req.perf.isAutoFragments())
+        autoFragmentJobs.insert(id);
+    else
+        jobFragments.insert(id, req.perf.fragments);
+    if (req.rawAudio)
+        awaitingPost.insert(id, req);
+    if (planned)
+    {
+        plans.insert(id, plan);
+        emit logLine(QString("[#%1] plan: %2").arg(id).arg(plan.describe()));
+    }
+
+    stats.total++;
+    emit batchChanged();
+    emit logLine(QString("[#%1] queued: %2 %3").arg(id).arg(ytDlp, args.join(" ")));
+    return true;
+}
+
+void DownloadManager::playlistExpanded(const QString &url, const PlaylistInfo &info)
+{
+    if (!pendingPlaylists.contains(url)) { return; }
+    DownloadRequest req = pendingPlaylists.take(url);
+
+    // its entries are known one by one from here on
+    knownUrls.remove(canonicalizeUrl(url).key());
+
+    QString folder = info.title.isEmpty() ? info.id : info.title;
+    sanitizeFilename(folder);
+    if (folder.isEmpty()) folder = "playlist";
+
+    QString playlistDir = req.outputDir + "/" + folder;
+    QSet<int> done = PlaylistExpander::existingIndices(playlistDir);
+
+    // every entry is a single video now, keeping the playlist's index naming
+    req.noPlaylist = true;
+    req.customName.clear();
+
+    int queued = 0;
+    for (const PlaylistEntry &e : info.entries)
+    {
+        if (done.contains(e.index)) { continue; }
+
+        DownloadRequest entry = req;
+        entry.url = e.url;
+        entry.outputTemplate = playlistDir + "/" + PlaylistExpander::indexPrefix(e.index) + "%(title)s.%(ext)s";
+        if (enqueueRequest(entry, e.extractor, e.id))
+            queued++;
+    }
+
+    emit logLine(QString("Playlist \"%1\": %2 entries, %3 already downloaded, %4 queued")
+        .arg(folder).arg(info.entries.size()).arg(info.entries.size() - queued).arg(queued));
+
+    checkFinished();
+}
+
+void DownloadManager::playlistFailed(const QString &url, const QString &error)
+{
+    if (!pendingPlaylists.remove(url)) { return; }
+
+    knownUrls.remove(canonicalizeUrl(url).key());
+    emit logLine("Could not list playlist " + url + ": " + error);
+    stats.failed++;
+    emit batchChanged();
+
+    checkFinished();
+}
+
+
+// ---------- bookkeeping ----------
+void DownloadManager::jobFinished(int id, int, JobState state)
+{
+    const DownloadJob* j = jobs->job(id);
+    if (j)
+        recordThroughput(*j);
+
+    // transient failures go back to the queue, everything else is final
+    if (state == JobState::Failed && j && retryFailed(*j))
+    {
+        emit batchChanged();
+        return;
+    }
+    retry->forget(id);
+
+    // a finished file keeps its name, anything else gives it back
+    bool nameReserved = jobNames.contains(id);
+    if (state == JobState::Finished && j && unnamedJobs.contains(id))
+    {
+        for (const QString &path : j->destinations)
+        {
+            QFileInfo fi(path);
+            fileNames.claim(fi.absolutePath(), fi.completeBaseName());
+        }
+    }
+    if (state == JobState::Finished)
+    {
+        jobNames.remove(id);
+        unnamedJobs.remove(id);
+    }
+    else
+    {
+        releaseOutputName(id);
+    }
+
+    DownloadRequest req = awaitingPost.take(id);
+
+    switch (state)
+    {
+        case JobState::Finished:
+            // counted as done once the conversion is through
+            if (req.rawAudio && j)
+            {
+                startPostProcessing(*j, req, nameReserved);
+                break;
+            }
+            stats.done++;
+            if (j)
+                history.record(j->extractor, j->videoId);
+            break;
+        case JobState::Canceled:
+            stats.canceled++;
+            break;
+        default:
+            stats.failed++;
+            break;
+    }
+
+    autoFragmentJobs.remove(id);
+    jobFragments.remove(id);
+
+    // audio jobs still need theirs for the conversion, and stay queued
+    // until it is done; otherwise the URL may be pasted again (the archive
+    // catches what was fetched, in another mode it is a new download)
+    if (!post->isQueued(id))
+    {
+        plans.remove(id);
+        knownUrls.remove(jobKeys.take(id));
+    }
+
+    emit batchChanged();
+}
+
+bool DownloadManager::retryFailed(const DownloadJob &j)
+{
+    Failure f = classifyFailure(j.output, j.exitCode);
+    if (retry->handle(j.id, f)) { return true; }
+
+    if (!f.message.isEmpty())
+        emit logLine(QString("[#%1] %2: %3").arg(j.id).arg(f.kindName(), f.message));
+    else
+        emit logLine(QString("[#%1] %2").arg(j.id).arg(f.kindName()));
+    return false;
+}
+
+void DownloadManager::startPostProcessing(const DownloadJob &j, const DownloadRequest &req, bool nameReserved)
+{
+    static const QStringList images{"jpg", "jpeg", "png", "webp"};
+
+    PostProcessTask task;
+    task.jobId = j.id;
+    task.format = req.format;
+    task.audioQuality = req.audioQuality;
+    task.loudnorm = loudnorm;
+    task.settings = transcode;
+    task.replace = nameReserved;
+
+    // the last media file and the last thumbnail yt-dlp mentioned
+    for (const QString &path : j.destinations)
+    {
+        if (images.contains(QFileInfo(path).suffix().toLower()))
+            task.thumbnail = path;
+        else
+            task.input = path;
+    }
+
+    if (task.input.isEmpty() || !QFileInfo::exists(task.input))
+    {
+        emit logLine(QString("[#%1] downloaded file not found, nothing to convert").arg(j.id));
+        stats.failed++;
+        if (journal && jobUids.contains(j.id))
+            journal->finished(jobUids.take(j.id), "failed");
+        return;
+    }
+    // --convert-thumbnails replaced it after the line naming it was printed
+    if (!task.thumbnail.isEmpty() && !QFileInfo::exists(task.thumbnail))
+    {
+        QFileInfo fi(task.thumbnail);
+        task.thumbnail = fi.dir().filePath(fi.completeBaseName() + ".jpg");
+    }
+    if (!QFileInfo::exists(task.thumbnail))
+        task.thumbnail.clear();
+
+    // without metadata, YouTube's webm audio is the one safe guess for opus
+    if (plans.contains(j.id))
+        task.copy = plans.value(j.id).mode == TranscodeMode::Copy;
+    else
+        task.copy = req.format == "opus" && req.audioQuality == "Best"
+                    && QFileInfo(task.input).suffix().toLower() == "webm";
+
+    post->submit(task);
+}
+
+void DownloadManager::postProcessed(int id, bool ok, const QString &message, const PostProcessReport &report)
+{
+    plans.remove(id);
+    knownUrls.remove(jobKeys.take(id));
+
+    if (ok)
+    {
+        stats.done++;
+        if (const DownloadJob* j = jobs->job(id))
+            history.record(j->extractor, j->videoId);
+
+        QString cost = report.cpuSeconds >= 0
+            ? QString("%1 s CPU, %2 s").arg(report.cpuSeconds, 0, 'f', 2).arg(report.wallSeconds, 0, 'f', 1)
+            : QString("%1 s").arg(report.wallSeconds, 0, 'f', 1);
+        emit logLine(QString("[#%1] %2 (%3): %4")
+            .arg(id).arg(report.copied ? "stream copy" : "transcoded", cost, message));
+    }
+    else if (message == "canceled")
+    {
+        stats.canceled++;
+    }
+    else
+    {
+        stats.failed++;
+        emit logLine(QString("[#%1] conversion failed: %2").arg(id).arg(message));
+    }
+
+    if (journal && jobUids.contains(id))
+        journal->finished(jobUids.take(id), ok ? "finished" : message == "canceled" ? "canceled" : "failed");
+
+    emit batchChanged();
+    checkFinished();
+}
+
+void DownloadManager::checkFinished()
+{
+    if (isIdle())
+        emit finished();
+}
+
+
+// ---------- fragment tuning ----------
+QStringList DownloadManager::fragmentArgs(int id)
+{
+    if (!autoFragmentJobs.contains(id)) { return {}; }
+
+    // picked at launch, so a restart after a worker change gets a new value
+    int n = PerformanceProfile::autoFragments(jobs->maxWorkers(), maxConnections);
+    jobFragments.insert(id, n);
+    return {"--concurrent-fragments", QString::number(n)};
+}
+
+// one CSV row per finished job, to tune the auto mode from real downloads
+void DownloadManager::recordThroughput(const DownloadJob &j)
+{
+    if (throughputLog.fileName().isEmpty()) { return; }
+    if (j.state != JobState::Finished || j.startedAt == 0) { return; }
+
+    if (!throughputLog.isOpen())
+    {
+        QDir().mkpath(QFileInfo(throughputLog.fileName()).absolutePath());
+        if (!throughputLog.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+        {
+            qWarning() << "Could not open throughput log:" << throughputLog.fileName();
+            throughputLog.setFileName(QString());
+            return;
+        }
+        if (throughputLog.size() == 0)
+            throughputLog.write("finished_at,extractor,fragments,workers,cores,target_rate,bytes,seconds,bytes_per_sec\n");
+    }
+
+    double seconds = qMax<qint64>(1, j.finishedAt - j.startedAt) / 1000.0;
+    QString row = QString("%1,%2,%3,%4,%5,%6,%7,%8,%9\n")
+        .arg(QDateTime::fromMSecsSinceEpoch(j.finishedAt).toString(Qt::ISODate))
+        .arg(j.extractor.isEmpty() ? "unknown" : j.extractor)
+        .arg(jobFragments.value(j.id, 1))
+        .arg(jobs->maxWorkers())
+        .arg(QThread::idealThreadCount())
+        .arg(rates->targetRate())
+        .arg(j.receivedBytes)
+        .arg(seconds, 0, 'f', 1)
+        .arg(qint64(j.receivedBytes / seconds));
+
+    throughputLog.write(row.toUtf8());
+    throughputLog.flush();
+}
@@ -0,0 +1,197 @@
+#ifndef DOWNLOAD_MANAGER_HPP
+#define DOWNLOAD_MANAGER_HPP
+
+#include "download_request.hpp"
+#include "download_queue.hpp"
+#include "metadata_service.hpp"
+#include "playlist_expander.hpp"
+#include "download_archive.hpp"
+#include "dependency_manager.hpp"
+#include "bandwidth_scheduler.hpp"
+#include "host_scheduler.hpp"
+#include "storage_manager.hpp"
+#include "job_journal.hpp"
+#include "post_processor.hpp"
+#include "metrics.hpp"
+#include "retry_scheduler.hpp"
+#include "url_ingest.hpp"
+#include "output_template.hpp"
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QFile>
+#include <QTimer>
+
+
+// Turns DownloadRequests into queue jobs: expands playlists, resolves
+// exact formats from cached metadata and skips archived items. Used by
+// both MainWindow and the headless runner.
+class DownloadManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct BatchStats
+    {
+        int total = 0;
+        int done = 0;
+        int failed = 0;
+        int canceled = 0;
+
+        int finished() const { return done + failed + canceled; }
+    };
+
+    struct IngestStats
+    {
+        int accepted = 0;
+        int duplicates = 0;   // already queued or listed in this session
+        int archived = 0;     // in the download archive
+        int invalid = 0;
+    };
+
+    // touches no files; the archive and the templates are read by
+    // openArchive() and loadTemplates(), so a window can show first
+    explicit DownloadManager(QObject *parent = nullptr);
+
+    // the archive and templates.json named in the settings
+    void openArchive();
+    void loadTemplates();
+
+    static QString defaultDepsDir();
+    void setDepsDir(const QString &dir);
+    void setYtDlpPath(const QString &path);
+    QString ytDlpPath() const { return ytDlp; }
+    QString ffmpegPath() const { return ffmpeg; }
+
+    DownloadQueue* queue() const { return jobs; }
+    MetadataService* metadata() const { return meta; }
+    DependencyManager* dependencies() const { return deps; }
+    BandwidthScheduler* bandwidth() const { return rates; }
+    HostScheduler* hosts() const { return sites; }
+    StorageManager* storage() const { return disks; }
+    PostProcessor* postProcessor() const { return post; }
+    MetricsRecorder* metrics() const { return recorder; }
+    RetryScheduler* retries() const { return retry; }
+
+    // audio is converted by the PostProcessor pool instead of inside yt-dlp
+    void setSeparatePostProcessing(bool on) { separatePostProcessing = on; }
+    void setLoudnessNormalization(bool on) { loudnorm = on; }
+    DownloadArchive& archive() { return history; }
+    OutputTemplates& outputTemplates() { return templates; }
+
+    // an empty path disables the per-job throughput CSV
+    void setThroughputLog(const QString &path);
+
+    // jobs are journaled once this is open, so they survive a crash or exit;
+    // fails while another process has the same journal open
+    bool openJournal(const QString &path);
+    static QString defaultJournalPath();
+
+    // re-enqueues what the journal says was interrupted, returns how many
+    int resumeInterrupted();
+
+    void submit(const DownloadRequest &req);
+
+    // canonicalizes and dedups the URLs, then queues the rest with base's
+    // options a chunk per event loop turn, so thousands never block the UI
+    IngestStats submitUrls(const DownloadRequest &base, const QStringList &urls);
+    void cancelAll();
+
+    // one job, queued, running or waiting for a retry; false if it is
+    // unknown or already past that
+    bool cancel(int id);
+
+    const BatchStats& batch() const { return stats; }
+    void resetBatch();
+    bool isIdle() const
+    {
+        return jobs->isIdle() && pendingPlaylists.isEmpty() && post->isIdle() && retry->isIdle()
+            && backlog.isEmpty();
+    }
+
+signals:
+    void logLine(const QString &line);
+    void batchChanged();
+    void finished();
+
+private:
+    QString ytDlp;
+    QString ffmpeg;
+
+    DownloadQueue* jobs;
+    MetadataService* meta;
+    PlaylistExpander* playlists;
+    DependencyManager* deps;
+    BandwidthScheduler* rates;
+    HostScheduler* sites;
+    StorageManager* disks;
+    DownloadArchive history;
+
+    QHash<QString, DownloadRequest> pendingPlaylists;
+    BatchStats stats;
+
+    // --- bulk ingestion and its dedup index ---
+    QSet<QString> knownUrls;
+    QHash<int, QString> jobKeys;
+    QList<DownloadRequest> backlog;
+    QTimer backlogTimer;
+
+    void drainBacklog();
+
+    static constexpr int backlogChunk = 200;
+
+    // --- file names, picked before a job starts ---
+    struct ReservedName
+    {
+        QString dir;
+        QString name;
+    };
+
+    OutputTemplates templates;
+    NameIndex fileNames;
+    QHash<int, ReservedName> jobNames;
+    QSet<int> unnamedJobs;   // named by yt-dlp, indexed once finished
+
+    ReservedName assignOutputName(DownloadRequest &req, const VideoMetadata &md);
+    void releaseOutputName(int id);
+
+    // --- post-processing stage ---
+    PostProcessor* post;
+    bool separatePostProcessing = true;
+    bool loudnorm = false;
+    QHash<int, DownloadRequest> awaitingPost;
+    QHash<int, TranscodePlan> plans;
+    TranscodeSettings transcode;
+
+    void startPostProcessing(const DownloadJob &j, const DownloadRequest &req, bool nameReserved);
+    void postProcessed(int id, bool ok, const QString &message, const PostProcessReport &report);
+
+    MetricsRecorder* recorder;
+
+    // --- automatic retries of transient failures ---
+    RetryScheduler* retry;
+    bool retryFailed(const DownloadJob &j);
+    void dropWaitingRetry(int id);
+
+    // --- crash-safe job journal ---
+    JobJournal* journal = nullptr;
+    QHash<int, QString> jobUids;
+
+    // --- fragment tuning and its measurements ---
+    int maxConnections = 16;
+    QSet<int> autoFragmentJobs;
+    QHash<int, int> jobFragments;
+    QFile throughputLog;
+
+    QStringList fragmentArgs(int id);
+    void recordThroughput(const DownloadJob &j);
+
+    bool enqueueRequest(DownloadRequest req, const QString &extractor = {}, const QString &videoId = {});
+    void playlistExpanded(const QString &url, const PlaylistInfo &info);
+    void playlistFailed(const QString &url, const QString &error);
+    void jobFinished(int id, int exitCode, JobState state);
+    void checkFinished();
+};
+
+
+#endif // DOWNLOAD_MANAGER_HPP
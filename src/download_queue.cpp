@@ -0,0 +1,485 @@
+#include "download_queue.hpp"
+
+#include <QtGlobal>
+#include <utility>
+#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+
+QString jobStateName(JobState state)
+{
+    switch (state)
+    {
+        case JobState::Queued: return "queued";
+        case JobState::Running: return "running";
+        case JobState::Finished: return "finished";
+        case JobState::Failed: return "failed";
+        case JobState::Canceled: return "canceled";
+    }
+    return {};
+}
+
+// "[download] Destination: x", "[Merger] Merging formats into "x"",
+// "[download] x has already been downloaded", "[info] Writing video thumbnail 0 to: x"
+static QString destinationOf(const QString &line)
+{
+    static const QString destination = "Destination: ";
+    static const QString merging = "Merging formats into \"";
+    static const QString existing = " has already been downloaded";
+    static const QString thumbnail = "thumbnail ";
+    static const QString to = " to: ";
+
+    if (!line.startsWith('[')) { return {}; }
+
+    int i = line.indexOf(destination);
+    if (i > 0)
+        return line.mid(i + destination.size()).trimmed();
+
+    if (line.startsWith("[download] ") && line.endsWith(existing))
+        return line.mid(11, line.size() - 11 - existing.size());
+
+    i = line.indexOf(to);
+    if (i > 0 && line.lastIndexOf(thumbnail, i) > 0)
+        return line.mid(i + to.size()).trimmed();
+
+    i = line.indexOf(merging);
+    if (i > 0 && line.endsWith('"'))
+        return line.mid(i + merging.size(), line.size() - i - merging.size() - 1);
+
+    return {};
+}
+
+// "[MoveFiles] Moving file "a" to "b"", printed when a file leaves the -P temp: dir
+static bool movedFile(const QString &line, QString &from, QString &to)
+{
+    static const QString moving = "[MoveFiles] Moving file \"";
+    static const QString middle = "\" to \"";
+
+    if (!line.startsWith(moving) || !line.endsWith('"')) { return false; }
+
+    int i = line.indexOf(middle, moving.size());
+    if (i < 0) { return false; }
+
+    from = line.mid(moving.size(), i - moving.size());
+    to = line.mid(i + middle.size(), line.size() - i - middle.size() - 1);
+    return true;
+}
+
+DownloadQueue::DownloadQueue(QObject *parent)
+    : QObject(parent)
+{
+}
+
+DownloadQueue::~DownloadQueue()
+{
+    // QProcess only kills yt-dlp itself, not the ffmpeg it spawned
+    // nothing is reported as failed just because the app is closing
+    const QList<QProcess*> running = workers.values();
+    for (QProcess* p : running)
+    {
+        p->disconnect(this);
+        signalProcessTree(p, true);
+    }
+}
+
+void DownloadQueue::setProgram(const QString &program)
+{
+    ytDlpPath = program;
+}
+
+void DownloadQueue::setMaxWorkers(int n)
+{
+    workerLimit = qMax(1, n);
+    schedule();
+}
+
+int DownloadQueue::enqueue(const QString &url, const QStringList &args,
+                           const QString &extractor, const QString &videoId)
+{
+    DownloadJob j;
+    j.id = nextId++;
+    j.url = url;
+    j.args = args;
+    j.extractor = extractor;
+    j.videoId = videoId;
+
+    jobs.insert(j.id, j);
+    order.append(j.id);
+    pending.append(j.id);
+
+    emit jobQueued(j.id);
+    schedule();
+    return j.id;
+}
+
+const DownloadJob* DownloadQueue::job(int id) const
+{
+    auto it = jobs.constFind(id);
+    return (it == jobs.constEnd()) ? nullptr : &it.value();
+}
+
+void DownloadQueue::cancel(int id)
+{
+    if (pending.removeOne(id))
+    {
+        finishJob(id, -1, JobState::Canceled);
+        return;
+    }
+
+    QProcess* p = workers.value(id, nullptr);
+    if (!p) { return; }
+
+    // the finished handler picks the state up from here
+    DownloadJob &j = jobs[id];
+    if (j.state == JobState::Canceled) { return; }
+    j.state = JobState::Canceled;
+
+    restarting.remove(id);
+    stopProcess(p);
+}
+
+void DownloadQueue::restart(int id)
+{
+    QProcess* p = workers.value(id, nullptr);
+    if (!p) { return; }
+    if (jobs[id].state == JobState::Canceled) { return; }
+
+    restarting.insert(id);
+    stopProcess(p);
+}
+
+bool DownloadQueue::retry(int id)
+{
+    auto it = jobs.find(id);
+    if (it == jobs.end() || it->state != JobState::Failed) { return false; }
+
+    it->state = JobState::Queued;
+    it->exitCode = -1;
+    it->finishedAt = 0;
+    it->progress = ProgressEvent();
+    it->output.clear();
+    pending.append(id);
+
+    emit jobQueued(id);
+    schedule();
+    return true;
+}
+
+bool DownloadQueue::fail(int id, const QString &error)
+{
+    if (!pending.removeOne(id)) { return false; }
+
+    jobs[id].output.append("ERROR: " + error.toUtf8() + '\n');
+    finishJob(id, -1, JobState::Failed);
+    schedule();
+    return true;
+}
+
+void DownloadQueue::cancelAll()
+{
+    // drop pending jobs first so finishing workers don't start them
+    const QList<int> waiting = pending;
+    pending.clear();
+    for (int id : waiting)
+        finishJob(id, -1, JobState::Canceled);
+
+    const QList<int> running = workers.keys();
+    for (int id : running)
+        cancel(id);
+}
+
+
+// ---------- scheduling ----------
+void DownloadQueue::schedule()
+{
+    while (workers.size() < workerLimit && !pending.isEmpty())
+    {
+        if (admission && !admission()) { return; }
+
+        if (gates.isEmpty())
+        {
+            int next = picker ? picker(pending) : 0;
+            if (next < 0 || next >= pending.size()) { return; }
+            startJob(pending.takeAt(next));
+            continue;
+        }
+
+        QList<int> open;
+        for (int id : std::as_const(pending))
+            if (passesGates(id)) { open << id; }
+        if (open.isEmpty()) { return; }
+
+        int next = picker ? picker(open) : 0;
+        if (next < 0 || next >= open.size()) { return; }
+        pending.removeOne(open[next]);
+        startJob(open[next]);
+    }
+}
+
+bool DownloadQueue::passesGates(int id) const
+{
+    for (const auto &gate : gates)
+        if (!gate(id)) { return false; }
+    return true;
+}
+
+void DownloadQueue::startJob(int id)
+{
+    DownloadJob &j = jobs[id];
+    j.state = JobState::Running;
+
+    if (j.startedAt == 0)
+        j.startedAt = QDateTime::currentMSecsSinceEpoch();
+
+    QStringList args = ProgressParser::arguments();
+    for (const auto &provider : std::as_const(launchArgs))
+        args << provider(id);
+    args << j.args;
+
+    QProcess* p = new QProcess(this);
+    p->setProcessChannelMode(QProcess::MergedChannels);
+#ifdef Q_OS_UNIX
+    // own process group, so ffmpeg children can be signaled together
+    p->setChildProcessModifier([] { ::setpgid(0, 0); });
+#endif
+    workers.insert(id, p);
+
+    connect(p, &QProcess::readyReadStandardOutput, this, [=] {
+        readOutput(id, p);
+    });
+
+    connect(p, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+        this,
+        [=](int code, QProcess::ExitStatus status) {
+            readOutput(id, p);
+
+            if (restarting.remove(id))
+            {
+                requeue(id);
+                return;
+            }
+
+            JobState s = JobState::Failed;
+            if (jobs[id].state == JobState::Canceled)
+                s = JobState::Canceled;
+            else if (status == QProcess::NormalExit && code == 0)
+                s = JobState::Finished;
+
+            finishJob(id, code, s);
+        });
+
+    // finished() is never emitted when the binary cannot be launched
+    connect(p, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            finishJob(id, -1, JobState::Failed);
+    });
+
+    emit jobStarted(id);
+    p->start(ytDlpPath, args);
+}
+
+void DownloadQueue::requeue(int id)
+{
+    if (QProcess* p = workers.take(id))
+    {
+        p->disconnect(this);
+        p->deleteLater();
+    }
+    partialLines.remove(id);
+
+    jobs[id].state = JobState::Queued;
+    pending.prepend(id);
+
+    emit jobQueued(id);
+    schedule();
+}
+
+void DownloadQueue::readOutput(int id, QProcess *p)
+{
+    QByteArray b = p->readAllStandardOutput();
+    if (b.isEmpty()) { return; }
+
+    bytesRead += b.size();
+
+    QByteArray &buf = partialLines[id];
+    buf.append(b);
+
+    // only whole lines are handed on, the rest waits for the next chunk
+    int end = buf.lastIndexOf('\n');
+    if (end < 0) { return; }
+
+    QStringList lines;
+    bool hasProgress = false;
+
+    int start = 0;
+    while (start <= end)
+    {
+        int nl = buf.indexOf('\n', start);
+        handleLine(id, buf.mid(start, nl - start), lines, hasProgress);
+        start = nl + 1;
+    }
+    buf.remove(0, end + 1);
+
+    // a chunk often holds many progress lines, only the newest one matters
+    if (hasProgress)
+        emit jobProgress(id, jobs[id].progress);
+    if (!lines.isEmpty())
+        emit jobLines(id, lines);
+}
+
+void DownloadQueue::handleLine(int id, const QByteArray &raw, QStringList &lines, bool &hasProgress)
+{
+    linesRead++;
+
+    QString line = QString::fromLocal8Bit(raw);
+    if (line.endsWith('\r'))
+        line.chop(1);
+
+    DownloadJob &j = jobs[id];
+    ProgressEvent ev;
+    if (ProgressParser::parse(line, ev))
+    {
+        if (!ev.videoId.isEmpty() && ev.videoId != "NA")
+        {
+            j.extractor = ev.extractor;
+            j.videoId = ev.videoId;
+        }
+        // a new stream (video, then audio) starts counting from zero again
+        if (ev.kind == ProgressEvent::Kind::Download && ev.downloadedBytes >= 0)
+        {
+            qint64 prev = (j.progress.kind == ProgressEvent::Kind::Download) ? j.progress.downloadedBytes : -1;
+            j.receivedBytes += (prev >= 0 && ev.downloadedBytes >= prev) ? ev.downloadedBytes - prev : ev.downloadedBytes;
+        }
+
+        j.progress = ev;
+        hasProgress = true;
+        return;
+    }
+
+    QString from;
+    QString to;
+    if (movedFile(line, from, to))
+    {
+        // the file now lives in the output dir, later steps need that path
+        int i = j.destinations.indexOf(from);
+        if (i >= 0)
+            j.destinations[i] = to;
+        else if (!j.destinations.contains(to))
+            j.destinations << to;
+    }
+    else
+    {
+        QString file = destinationOf(line);
+        if (!file.isEmpty() && !j.destinations.contains(file))
+            j.destinations << file;
+    }
+
+    QByteArray &tail = j.output;
+    tail.append(raw).append('\n');
+    if (tail.size() > maxOutputTail)
+        tail.remove(0, tail.size() - maxOutputTail);
+
+    lines << line;
+}
+
+void DownloadQueue::finishJob(int id, int exitCode, JobState state)
+{
+    restarting.remove(id);
+
+    if (QProcess* p = workers.take(id))
+    {
+        p->disconnect(this);
+        p->deleteLater();
+    }
+
+    // output without a trailing newline
+    QByteArray rest = partialLines.take(id);
+    if (!rest.isEmpty())
+    {
+        QStringList lines;
+        bool hasProgress = false;
+        handleLine(id, rest, lines, hasProgress);
+        if (!lines.isEmpty())
+            emit jobLines(id, lines);
+    }
+
+    DownloadJob &j = jobs[id];
+    j.state = state;
+    j.exitCode = exitCode;
+    j.finishedAt = QDateTime::currentMSecsSinceEpoch();
+
+    if (state == JobState::Canceled)
+        removePartialFiles(j.destinations);
+
+    emit jobFinished(id, exitCode, state);
+
+    schedule();
+    if (isIdle())
+        emit idle();
+}
+
+
+// ---------- process cleanup ----------
+// SIGTERM first where there is one, then a kill after killTimeoutMs
+void DownloadQueue::stopProcess(QProcess *p)
+{
+    signalProcessTree(p, false);
+
+    // the timer dies with the process if it exits in time
+    QTimer::singleShot(killTimeoutMs, p, [p] {
+        if (p->state() != QProcess::NotRunning)
+            signalProcessTree(p, true);
+    });
+}
+
+void DownloadQueue::signalProcessTree(QProcess *p, bool force)
+{
+    qint64 pid = p->processId();
+    if (pid <= 0) { return; }
+
+#ifdef Q_OS_UNIX
+    int sig = force ? SIGKILL : SIGTERM;
+    // the group may not exist yet if the child has not run setpgid
+    if (::kill(-pid_t(pid), sig) != 0)
+        ::kill(pid_t(pid), sig);
+#elif defined(Q_OS_WIN)
+    // console programs have no window to close, so taskkill without /F
+    // refuses them just like terminate() does: there is no graceful step,
+    // the tree is always killed (yt-dlp still resumes from its .part file)
+    Q_UNUSED(force);
+    QProcess::startDetached("taskkill", {"/PID", QString::number(pid), "/T", "/F"});
+#else
+    if (force)
+        p->kill();
+    else
+        p->terminate();
+#endif
+}
+
+void DownloadQueue::removePartialFiles(const QStringList &destinations)
+{
+    for (const QString &path : destinations)
+    {
+        QFileInfo info(path);
+        QDir dir = info.absoluteDir();
+
+        QFile::remove(path + ".part");
+        QFile::remove(path + ".ytdl");
+
+        // fragments of HLS/DASH downloads and ffmpeg's merge output
+        const QStringList leftovers = dir.entryList({
+            info.fileName() + ".part-Frag*",
+            info.completeBaseName() + ".temp." + info.suffix(),
+        }, QDir::Files);
+        for (const QString &name : leftovers)
+            dir.remove(name);
+    }
+}
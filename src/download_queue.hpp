@@ -0,0 +1,125 @@
+#ifndef DOWNLOAD_QUEUE_HPP
+#define DOWNLOAD_QUEUE_HPP
+
+#include "download_job.hpp"
+#include <QObject>
+#include <QProcess>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <functional>
+
+
+// Runs yt-dlp jobs with at most maxWorkers() processes alive at once.
+// Jobs are started in FIFO order unless a picker says otherwise; every
+// job keeps its own state, exit code and output, independent of the
+// other workers. Canceling never blocks: yt-dlp and its ffmpeg children
+// are asked to stop, killed after a timeout, and their partial files
+// removed once they are gone.
+class DownloadQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DownloadQueue(QObject *parent = nullptr);
+    ~DownloadQueue() override;
+
+    void setProgram(const QString &program);
+    QString program() const { return ytDlpPath; }
+
+    void setMaxWorkers(int n);
+    int maxWorkers() const { return workerLimit; }
+
+    // how long a canceled yt-dlp gets to exit before it is killed
+    void setKillTimeout(int ms) { killTimeoutMs = ms; }
+
+    // hooks for schedulers: extra arguments added right before a job
+    // starts (e.g. --limit-rate), a check that can hold jobs back, checks
+    // that hold single jobs back (they are not offered to the picker), and
+    // which pending job goes next (an index into them, -1 for none)
+    void addLaunchArgs(std::function<QStringList(int id)> f) { launchArgs << f; }
+    void setAdmission(std::function<bool()> f) { admission = f; }
+    void addGate(std::function<bool(int id)> f) { gates << f; }
+    void setPicker(std::function<int(const QList<int> &pending)> f) { picker = f; }
+
+    // the id the next enqueue() hands out, for bookkeeping a gate needs
+    // before the job may already be started by it
+    int nextJobId() const { return nextId; }
+
+    int enqueue(const QString &url, const QStringList &args,
+                const QString &extractor = {}, const QString &videoId = {});
+    void cancel(int id);
+    void cancelAll();
+
+    // stops a running job and puts it back at the front of the queue,
+    // yt-dlp resumes from its .part file when it is started again
+    void restart(int id);
+
+    // puts a failed job back at the end of the queue under the same id;
+    // its partial files are kept and the old output is dropped
+    bool retry(int id);
+
+    // fails a pending job without starting it, for a gate that knows it
+    // will never let the job through; error ends up in its output
+    bool fail(int id, const QString &error);
+
+    // starts pending jobs the admission check used to hold back
+    void wake() { schedule(); }
+
+    const DownloadJob* job(int id) const;
+    QList<int> jobIds() const { return order; }
+
+    int runningCount() const { return workers.size(); }
+    int pendingCount() const { return pending.size(); }
+    bool isIdle() const { return workers.isEmpty() && pending.isEmpty(); }
+
+    // everything read from yt-dlp so far, for benchmarks
+    qint64 outputBytes() const { return bytesRead; }
+    qint64 outputLines() const { return linesRead; }
+
+signals:
+    void jobQueued(int id);
+    void jobStarted(int id);
+    void jobProgress(int id, const ProgressEvent &ev);
+    void jobLines(int id, const QStringList &lines);
+    void jobFinished(int id, int exitCode, JobState state);
+    void idle();
+
+private:
+    QString ytDlpPath;
+    int workerLimit = 3;
+    int nextId = 1;
+    int killTimeoutMs = 5000;
+    qint64 bytesRead = 0;
+    qint64 linesRead = 0;
+
+    QHash<int, DownloadJob> jobs;
+    QList<int> order;
+    QList<int> pending;
+    QHash<int, QProcess*> workers;
+    QHash<int, QByteArray> partialLines;
+    QSet<int> restarting;
+
+    QList<std::function<QStringList(int)>> launchArgs;
+    std::function<bool()> admission;
+    QList<std::function<bool(int)>> gates;
+    std::function<int(const QList<int> &)> picker;
+
+    void schedule();
+    bool passesGates(int id) const;
+    void startJob(int id);
+    void readOutput(int id, QProcess *p);
+    void handleLine(int id, const QByteArray &raw, QStringList &lines, bool &hasProgress);
+    void finishJob(int id, int exitCode, JobState state);
+
+    void stopProcess(QProcess *p);
+    void requeue(int id);
+
+    static void signalProcessTree(QProcess *p, bool force);
+    static void removePartialFiles(const QStringList &destinations);
+
+    static constexpr int maxOutputTail = 64 * 1024;
+};
+
+
+#endif // DOWNLOAD_QUEUE_HPP
@@ -0,0 +1,233 @@
+#include "download_request.hpp"
+
+#include <QRegularExpression>
+
+
+// ---------- Helper functions ----------
+// one pass over the name: reserved characters become "_", control
+// characters are dropped and the result is cut at a whole code point once
+// it would no longer fit in maxLength UTF-8 bytes (or UTF-16 units)
+void sanitizeFilename(QString &s, int maxLength, bool utf16Units)
+{
+    QString out;
+    out.reserve(qMin(int(s.size()), maxLength));
+
+    int length = 0;
+    int keep = 0;   // out.size() without trailing spaces and dots
+    for (int i = 0; i < s.size(); i++)
+    {
+        QChar c = s[i];
+        ushort u = c.unicode();
+
+        int units = 1;
+        int bytes = u < 0x80 ? 1 : (u < 0x800 ? 2 : 3);
+        if (c.isHighSurrogate() && i + 1 < s.size() && s[i + 1].isLowSurrogate())
+        {
+            units = 2;
+            bytes = 4;
+        }
+        else if (c.isSurrogate())
+        {
+            continue;   // unpaired, not valid in any file system encoding
+        }
+
+        if (u < 0x20 || u == 0x7f) { continue; }
+
+        // leading whitespace is skipped
+        if (out.isEmpty() && c.isSpace()) { continue; }
+
+        int cost = utf16Units ? units : bytes;
+        if (length + cost > maxLength) { break; }
+        length += cost;
+
+        switch (u)
+        {
+            case '\\': case '/': case ':': case '*': case '?':
+            case '"': case '<': case '>': case '|':
+                out += '_';
+                break;
+            default:
+                out += c;
+                if (units == 2)
+                    out += s[++i];
+                break;
+        }
+
+        // Windows drops trailing spaces and dots
+        if (!c.isSpace() && u != '.')
+            keep = out.size();
+    }
+    out.truncate(keep);
+
+    // device names are reserved on Windows whatever the extension, so the
+    // stem itself changes: "CON.mp4" becomes "CON_.mp4"
+    static const QStringList reserved = {"CON", "PRN", "AUX", "NUL",
+        "COM1", "COM2", "COM3", "COM4", "COM5", "COM6", "COM7", "COM8", "COM9",
+        "LPT1", "LPT2", "LPT3", "LPT4", "LPT5", "LPT6", "LPT7", "LPT8", "LPT9"};
+    QString stem = out.section('.', 0, 0);
+    if (reserved.contains(stem, Qt::CaseInsensitive) && length < maxLength)
+        out.insert(stem.size(), '_');
+
+    s = out;
+}
+
+bool isPlaylistUrl(const QString &url)
+{
+    static const QRegularExpression re(R"(([\?&])list=)");
+    return re.match(url).hasMatch();
+}
+
+bool isHttpUrl(const QString &url)
+{
+    return url.startsWith("http://") || url.startsWith("https://");
+}
+
+
+// ---------- DownloadRequest ----------
+int DownloadRequest::maxHeight() const
+{
+    QString qualityValue = videoQuality;
+    qualityValue.remove("p"); // ex: "720p" -> "720"
+
+    if (videoQuality == "Best" || videoQuality == "4K")
+        qualityValue = "2160"; // 4K = 2160p
+
+    return qualityValue.toInt();
+}
+
+QString DownloadRequest::formatSelector() const
+{
+    if (isAudio()) { return {}; }
+    return QString("bestvideo[height<=%1]+bestaudio/best").arg(maxHeight());
+}
+
+QString DownloadRequest::resolvedOutputTemplate() const
+{
+    if (!outputTemplate.isEmpty())
+        return outputTemplate;
+    if (!customName.isEmpty())
+        return outputDir + "/" + customName + ".%(ext)s";
+    if (isPlaylistUrl(url) && !noPlaylist)
+        return outputDir + "/%(playlist)s/%(playlist_index)03d - %(title)s.%(ext)s";
+    return outputDir + "/%(title)s.%(ext)s";
+}
+
+DownloadRequest DownloadRequest::fromJson(const QJsonObject &o, const DownloadRequest &defaults)
+{
+    DownloadRequest req = defaults;
+    req.url = o.value("url").toString(defaults.url).trimmed();
+    req.mode = o.value("mode").toString(defaults.mode);
+    req.format = o.value("format").toString();
+    if (req.format.isEmpty())
+    {
+        // the default container only makes sense for the default mode
+        if (req.mode == defaults.mode)
+            req.format = defaults.format;
+        else
+            req.format = req.isAudio() ? "mp3" : "mp4";
+    }
+    req.cookiesBrowser = o.value("cookies").toString(defaults.cookiesBrowser);
+    req.outputDir = o.value("dir").toString(defaults.outputDir);
+    req.customName = o.value("name").toString(defaults.customName);
+    sanitizeFilename(req.customName);
+    req.perf = PerformanceProfile::fromJson(o, defaults.perf);
+    req.exactFormat = o.value("exact_format").toString(defaults.exactFormat);
+    req.outputTemplate = o.value("output_template").toString(defaults.outputTemplate);
+    req.noPlaylist = o.value("no_playlist").toBool(defaults.noPlaylist);
+
+    if (o.contains("quality"))
+    {
+        if (req.isAudio())
+            req.audioQuality = o.value("quality").toString();
+        else
+            req.videoQuality = o.value("quality").toString();
+    }
+
+    return req;
+}
+
+QJsonObject DownloadRequest::toJson() const
+{
+    QJsonObject o{
+        {"url", url},
+        {"mode", mode},
+        {"format", format},
+        {"quality", isAudio() ? audioQuality : videoQuality},
+        {"dir", outputDir},
+    };
+    if (!cookiesBrowser.isEmpty()) o.insert("cookies", cookiesBrowser);
+    if (!customName.isEmpty()) o.insert("name", customName);
+    if (!exactFormat.isEmpty()) o.insert("exact_format", exactFormat);
+    if (!outputTemplate.isEmpty()) o.insert("output_template", outputTemplate);
+    if (noPlaylist) o.insert("no_playlist", true);
+
+    perf.toJson(o);
+    return o;
+}
+
+
+// ---------- argument builder ----------
+QStringList buildYtDlpArgs(const DownloadRequest &req, const QString &ffmpegPath)
+{
+    // --- base arguments ---
+    QStringList args;
+    args << "--ffmpeg-location" << ffmpegPath;
+
+    // --- adding cookies ---
+    if (!req.cookiesBrowser.isEmpty())
+    {
+        args << "--cookies-from-browser" << req.cookiesBrowser;
+    }
+
+    // --- audio mode ---
+    if (req.isAudio() && req.rawAudio)
+    {
+        // converted by the PostProcessor once the download slot is free;
+        // the cover as jpg, which every player shows (webp is not)
+        args << "--write-thumbnail" << "--convert-thumbnails" << "jpg";
+    }
+    else if (req.isAudio())
+    {
+        args << "-x";
+
+        args << "--embed-thumbnail";
+
+        args << "--audio-format" << req.format;
+
+        if (req.audioQuality != "Best")
+            args << "--audio-quality" << req.audioQuality;
+    }
+    else // --- video mode ---
+    {
+        args << "--merge-output-format" << req.format;
+    }
+
+    // --- format selection ---
+    if (!req.exactFormat.isEmpty())
+        args << "-f" << req.exactFormat;
+    else if (!req.isAudio())
+        args << "-f" << req.formatSelector();
+    else if (req.rawAudio)
+        args << "-f" << "bestaudio/best";
+
+    if (req.noPlaylist)
+        args << "--no-playlist";
+    if (req.resume)
+        args << "--continue";
+
+    // --- transfer tuning ---
+    args << req.perf.arguments();
+
+    // fragments and .part files go to the scratch dir, the finished file is
+    // renamed into place (the StorageManager only sets one on the same volume)
+    QString output = req.resolvedOutputTemplate();
+    QString home = req.outputDir + "/";
+    if (!req.tempDir.isEmpty() && output.startsWith(home))
+    {
+        args << "-P" << "home:" + req.outputDir << "-P" << "temp:" + req.tempDir;
+        output = output.mid(home.size());
+    }
+
+    args << req.url << "-o" << output;
+    return args;
+}
@@ -0,0 +1,52 @@
+#ifndef DOWNLOAD_REQUEST_HPP
+#define DOWNLOAD_REQUEST_HPP
+
+#include "performance_profile.hpp"
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+
+
+// Everything needed to turn one URL into a yt-dlp command line. It has no
+// dependency on widgets, so the GUI and the headless runner share it.
+struct DownloadRequest
+{
+    QString url;
+    QString mode = "video";          // video | audio
+    QString format = "mp4";          // mp4 / mkv for video, mp3 / opus for audio
+    QString videoQuality = "Best";   // 240p ... 1080p, 4K, Best
+    QString audioQuality = "Best";   // 128k ... 320k, Best
+    QString cookiesBrowser;          // empty for none
+    QString outputDir;
+    QString customName;              // sanitized, without extension
+
+    QString exactFormat;             // resolved format ID, wins over the quality selector
+    QString outputTemplate;          // full -o override, e.g. for playlist entries
+    QString tempDir;                 // .part files and fragments, on the same volume as outputDir
+    bool noPlaylist = false;
+    bool resume = false;             // passes --continue, for jobs replayed from the journal
+    bool rawAudio = false;           // audio is fetched as is and converted by the PostProcessor
+
+    PerformanceProfile perf;
+
+    bool isAudio() const { return mode == "audio"; }
+    int maxHeight() const;
+    QString formatSelector() const;
+    QString resolvedOutputTemplate() const;
+
+    // keys: url, mode, format, quality, cookies, dir, name, plus the PerformanceProfile keys;
+    // toJson() also writes exact_format, output_template and no_playlist
+    static DownloadRequest fromJson(const QJsonObject &o, const DownloadRequest &defaults);
+    QJsonObject toJson() const;
+};
+
+QStringList buildYtDlpArgs(const DownloadRequest &req, const QString &ffmpegPath);
+
+// file system friendly name, at most maxLength UTF-8 bytes (or UTF-16
+// units on file systems counting those) and never ending in a space or dot
+void sanitizeFilename(QString &s, int maxLength = 200, bool utf16Units = false);
+bool isPlaylistUrl(const QString &url);
+bool isHttpUrl(const QString &url);
+
+
+#endif // DOWNLOAD_REQUEST_HPP
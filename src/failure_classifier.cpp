@@ -0,0 +1,119 @@
+#include "failure_classifier.hpp"
+
+#include <QRegularExpression>
+#include <QList>
+
+
+// ---------- Helper functions ----------
+static bool containsAny(const QString &line, std::initializer_list<const char*> needles)
+{
+    for (const char *n : needles)
+        if (line.contains(QLatin1String(n), Qt::CaseInsensitive)) { return true; }
+    return false;
+}
+
+// the order matters: a 429 line often also says "Unable to download"
+static FailureKind kindOf(const QString &line)
+{
+    static const QRegularExpression serverError("HTTP Error 5\\d\\d");
+
+    if (containsAny(line, {"HTTP Error 429", "Too Many Requests", "rate-limit", "rate limit"}))
+        return FailureKind::RateLimited;
+    if (containsAny(line, {"No space left on device", "Not enough space", "Permission denied", "Disk quota exceeded", "Read-only file system"}))
+        return FailureKind::Disk;
+    if (containsAny(line, {"Private video", "Video unavailable", "is not available", "HTTP Error 404",
+                           "Unsupported URL", "members-only", "Sign in to confirm your age",
+                           "copyright", "has been removed", "geo restrict", "not available in your country"}))
+        return FailureKind::Unavailable;
+    if (containsAny(line, {"HTTP Error 403", "Forbidden"}))
+        return FailureKind::Forbidden;
+    if (containsAny(line, {"fragment", "Did not get any data blocks"}))
+        return FailureKind::Fragment;
+    if (serverError.match(line).hasMatch()
+        || containsAny(line, {"timed out", "Connection reset", "Connection refused", "Remote end closed",
+                              "IncompleteRead", "Temporary failure in name resolution", "Name or service not known",
+                              "Network is unreachable", "getaddrinfo failed", "Unable to download webpage",
+                              "SSL:", "EOF occurred"}))
+        return FailureKind::Network;
+    if (containsAny(line, {"Postprocessing:", "ffmpeg", "Conversion failed", "Error opening output"}))
+        return FailureKind::Ffmpeg;
+    if (containsAny(line, {"Unable to extract", "ExtractorError", "Failed to parse", "please report this issue"}))
+        return FailureKind::Extractor;
+    return FailureKind::Unknown;
+}
+
+
+// ---------- Failure ----------
+bool Failure::retryable() const
+{
+    switch (kind)
+    {
+        case FailureKind::RateLimited:
+        case FailureKind::Forbidden:
+        case FailureKind::Network:
+        case FailureKind::Fragment:
+            return true;
+        default:
+            return false;
+    }
+}
+
+QString Failure::kindName() const
+{
+    switch (kind)
+    {
+        case FailureKind::Unknown: return "unknown error";
+        case FailureKind::RateLimited: return "rate limited";
+        case FailureKind::Forbidden: return "forbidden";
+        case FailureKind::Network: return "network error";
+        case FailureKind::Fragment: return "fragment error";
+        case FailureKind::Unavailable: return "unavailable";
+        case FailureKind::Extractor: return "extractor error";
+        case FailureKind::Ffmpeg: return "ffmpeg error";
+        case FailureKind::Disk: return "disk error";
+        case FailureKind::NotStarted: return "not started";
+    }
+    return {};
+}
+
+
+// ---------- classification ----------
+Failure classifyFailure(const QByteArray &output, int exitCode)
+{
+    static const QRegularExpression retryAfter("Retry-After:?\\s*(\\d+)", QRegularExpression::CaseInsensitiveOption);
+
+    Failure f;
+    if (exitCode < 0 && output.trimmed().isEmpty())
+    {
+        f.kind = FailureKind::NotStarted;
+        return f;
+    }
+
+    const QList<QByteArray> lines = output.split('\n');
+
+    // yt-dlp's own verdict is the last ERROR line
+    for (int i = lines.size() - 1; i >= 0; i--)
+    {
+        QString line = QString::fromUtf8(lines[i]).trimmed();
+        if (!line.startsWith("ERROR:")) { continue; }
+        f.message = line;
+        f.kind = kindOf(line);
+        break;
+    }
+
+    // otherwise the warnings before it may tell, e.g. a fragment giving up
+    for (int i = lines.size() - 1; i >= 0 && f.kind == FailureKind::Unknown; i--)
+    {
+        QString line = QString::fromUtf8(lines[i]).trimmed();
+        if (!line.startsWith("WARNING:")) { continue; }
+        f.kind = kindOf(line);
+        if (f.message.isEmpty())
+            f.message = line;
+    }
+
+    QRegularExpressionMatch m = retryAfter.match(QString::fromUtf8(output));
+    if (m.hasMatch())
+        f.retryAfter = m.captured(1).toInt();
+
+    return f;
+}
@@ -0,0 +1,37 @@
+#ifndef FAILURE_CLASSIFIER_HPP
+#define FAILURE_CLASSIFIER_HPP
+
+#include <QString>
+#include <QByteArray>
+
+
+enum class FailureKind {
+    Unknown,
+    RateLimited,    // HTTP 429
+    Forbidden,      // HTTP 403, usually an expired signed URL
+    Network,        // timeouts, resets, DNS, HTTP 5xx
+    Fragment,       // a DASH/HLS fragment gave up
+    Unavailable,    // private, removed, geo-blocked, unsupported URL
+    Extractor,      // yt-dlp could not parse the page, usually needs an update
+    Ffmpeg,         // merging or converting failed
+    Disk,           // no space left, permission denied
+    NotStarted      // yt-dlp itself could not be run
+};
+
+struct Failure
+{
+    FailureKind kind = FailureKind::Unknown;
+    QString message;    // the ERROR line it was recognized from
+    int retryAfter = 0; // seconds, when the server said so
+
+    // transient failures that a later attempt can get past
+    bool retryable() const;
+    QString kindName() const;
+};
+
+// Reads the tail of yt-dlp's output, last ERROR line first, and decides
+// what went wrong. Pure text matching; nothing is re-run to find out.
+Failure classifyFailure(const QByteArray &output, int exitCode);
+
+
+#endif // FAILURE_CLASSIFIER_HPP
@@ -0,0 +1,344 @@
+#include "headless_runner.hpp"
+#include "download_manager.hpp"
+
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+
+// ---------- Helper functions ----------
+static QTextStream& out()
+{
+    static QTextStream s(stdout);
+    return s;
+}
+
+static QTextStream& err()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+#ifdef Q_OS_UNIX
+static int signalPipe[2] = {-1, -1};
+
+static void onTerminationSignal(int sig)
+{
+    char c = char(sig);
+    ssize_t n = ::write(signalPipe[1], &c, 1);
+    Q_UNUSED(n);
+}
+
+// yt-dlp runs in its own process group, so Ctrl-C no longer reaches it;
+// SIGINT and SIGTERM are turned into a notifier on the event loop instead
+static QSocketNotifier* watchTerminationSignals(QObject *parent)
+{
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, signalPipe) != 0) { return nullptr; }
+
+    struct sigaction sa = {};
+    sa.sa_handler = onTerminationSignal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    ::sigaction(SIGINT, &sa, nullptr);
+    ::sigaction(SIGTERM, &sa, nullptr);
+
+    auto notifier = new QSocketNotifier(signalPipe[0], QSocketNotifier::Read, parent);
+    QObject::connect(notifier, &QSocketNotifier::activated, notifier, [] {
+        char c;
+        ssize_t n = ::read(signalPipe[0], &c, 1);
+        Q_UNUSED(n);
+    });
+    return notifier;
+}
+#endif
+
+// one URL per line, blank lines and "#" comments ignored, "-" is stdin
+static bool readUrlList(const QString &path, QStringList &urls)
+{
+    QFile f;
+    bool ok = false;
+    if (path == "-")
+    {
+        ok = f.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    }
+    else
+    {
+        f.setFileName(path);
+        ok = f.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!ok) { return false; }
+
+    while (!f.atEnd())
+    {
+        QString line = QString::fromUtf8(f.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) { continue; }
+        urls << line;
+    }
+    return true;
+}
+
+// either [job, ...] or {"defaults": {...}, "jobs": [job, ...]}
+static bool readJobFile(const QString &path, const DownloadRequest &defaults, QList<DownloadRequest> &requests)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) { return false; }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &error);
+    if (error.error != QJsonParseError::NoError) { return false; }
+
+    DownloadRequest base = defaults;
+    QJsonArray jobs;
+    if (doc.isArray())
+    {
+        jobs = doc.array();
+    }
+    else
+    {
+        base = DownloadRequest::fromJson(doc.object().value("defaults").toObject(), defaults);
+        jobs = doc.object().value("jobs").toArray();
+    }
+
+    for (const QJsonValue &v : jobs)
+    {
+        // a bare string is just a URL
+        QJsonObject o = v.isString() ? QJsonObject{{"url", v.toString()}} : v.toObject();
+        requests << DownloadRequest::fromJson(o, base);
+    }
+    return true;
+}
+
+
+// ---------- entry point ----------
+int runHeadless(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs yt-dlp downloads without opening a window.");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"headless", "Run without a window."},
+        {{"i", "input"}, "Text file with one URL per line (\"-\" for stdin).", "file"},
+        {{"j", "jobs"}, "JSON job file.", "file"},
+        {{"o", "output"}, "Destination directory (default: current directory).", "dir"},
+        {{"m", "mode"}, "video or audio (default: video).", "mode", "video"},
+        {{"f", "format"}, "mp4, mkv, mp3 or opus.", "format"},
+        {{"q", "quality"}, "240p ... 1080p, 4K, 128k ... 320k or Best.", "quality", "Best"},
+        {{"c", "cookies"}, "Browser to read cookies from.", "browser"},
+        {{"p", "parallel"}, "Downloads running at the same time.", "n"},
+        {"per-host", "Downloads running at the same time per site (0 for no limit).", "n"},
+        {"deps", "Directory holding yt-dlp and ffmpeg.", "dir"},
+        {"loudnorm", "Normalize the loudness of audio downloads."},
+        {"continue", "Journal the jobs and resume the ones an earlier run left unfinished."},
+        {{"N", "fragments"}, "Fragments downloaded at once per job, or \"auto\".", "n"},
+        {"limit-rate", "Bandwidth for all downloads together, e.g. 2M (0 for unlimited).", "rate"},
+        {"schedule", "Time-of-day budgets, e.g. \"08:00-18:00=1M;01:00-06:00=pause\".", "rules"},
+        {"retries", "Automatic retries of a download that failed transiently (0 to disable).", "n"},
+        {"template", "File name pattern, e.g. \"{uploader} - {title}\" (default: {title}).", "pattern"},
+        {"temp-dir", "Scratch directory for partial files, used when on the same drive as the output.", "dir"},
+    });
+    parser.addPositionalArgument("urls", "URLs to download.", "[urls...]");
+    parser.process(app);
+
+    DownloadRequest defaults;
+    defaults.mode = parser.value("mode");
+    defaults.format = parser.isSet("format") ? parser.value("format") : (defaults.isAudio() ? "mp3" : "mp4");
+    if (defaults.isAudio())
+        defaults.audioQuality = parser.value("quality");
+    else
+        defaults.videoQuality = parser.value("quality");
+    defaults.cookiesBrowser = parser.value("cookies");
+    defaults.outputDir = QDir(parser.isSet("output") ? parser.value("output") : QDir::currentPath()).absolutePath();
+    defaults.perf = PerformanceProfile::fromSettings();
+    if (parser.isSet("fragments"))
+        defaults.perf = PerformanceProfile::fromJson({{"fragments", parser.value("fragments")}}, defaults.perf);
+
+    // --- collecting jobs ---
+    QList<DownloadRequest> requests;
+    QStringList urls = parser.positionalArguments();
+
+    if (parser.isSet("input") && !readUrlList(parser.value("input"), urls))
+    {
+        err() << "Could not read URL list: " << parser.value("input") << Qt::endl;
+        return 2;
+    }
+    for (const QString &url : urls)
+    {
+        DownloadRequest req = defaults;
+        req.url = url;
+        requests << req;
+    }
+    if (parser.isSet("jobs") && !readJobFile(parser.value("jobs"), defaults, requests))
+    {
+        err() << "Could not read job file: " << parser.value("jobs") << Qt::endl;
+        return 2;
+    }
+
+    if (requests.isEmpty() && !parser.isSet("continue"))
+    {
+        err() << "Nothing to download." << Qt::endl;
+        parser.showHelp(2);
+    }
+
+    // --- manager ---
+    DownloadManager downloads;
+    downloads.openArchive();
+    downloads.loadTemplates();
+    if (parser.isSet("deps"))
+        downloads.setDepsDir(parser.value("deps"));
+    if (parser.isSet("parallel"))
+        downloads.queue()->setMaxWorkers(parser.value("parallel").toInt());
+    if (parser.isSet("per-host"))
+        downloads.hosts()->setMaxPerHost(parser.value("per-host").toInt());
+
+    if (parser.isSet("template"))
+    {
+        if (!OutputTemplates::isValid(parser.value("template")))
+        {
+            err() << "Invalid template: " << parser.value("template") << Qt::endl;
+            return 2;
+        }
+        downloads.outputTemplates().setDefaultPattern(parser.value("template"));
+    }
+    if (parser.isSet("temp-dir"))
+        downloads.storage()->setScratchDir(parser.value("temp-dir"));
+
+    if (parser.isSet("loudnorm"))
+        downloads.setLoudnessNormalization(true);
+
+    if (parser.isSet("retries"))
+    {
+        RetryPolicy policy = downloads.retries()->policy();
+        policy.maxAttempts = qMax(0, parser.value("retries").toInt());
+        downloads.retries()->setPolicy(policy);
+    }
+
+    if (parser.isSet("limit-rate"))
+    {
+        bool ok = false;
+        qint64 rate = BandwidthScheduler::parseRate(parser.value("limit-rate"), &ok);
+        if (!ok)
+        {
+            err() << "Invalid rate: " << parser.value("limit-rate") << Qt::endl;
+            return 2;
+        }
+        downloads.bandwidth()->setLimit(rate);
+    }
+    if (parser.isSet("schedule"))
+    {
+        QList<BandwidthRule> rules;
+        if (!BandwidthScheduler::parseSchedule(parser.value("schedule"), rules))
+        {
+            err() << "Invalid schedule: " << parser.value("schedule") << Qt::endl;
+            return 2;
+        }
+        downloads.bandwidth()->setSchedule(rules);
+    }
+
+    QFileInfo ytDlp(downloads.ytDlpPath());
+    if (!ytDlp.exists() || !ytDlp.isExecutable())
+    {
+        err() << "yt-dlp not found or not executable: " << downloads.ytDlpPath() << Qt::endl;
+        return 2;
+    }
+
+    DownloadQueue* queue = downloads.queue();
+    QHash<int, qint64> lastPrint;
+    QElapsedTimer clock;
+    clock.start();
+
+    QObject::connect(&downloads, &DownloadManager::logLine, [](const QString &line) {
+        out() << line << Qt::endl;
+    });
+
+    QObject::connect(queue, &DownloadQueue::jobLines, [](int id, const QStringList &lines) {
+        for (const QString &line : lines)
+            out() << "[#" << id << "] " << line << '\n';
+        out().flush();
+    });
+
+    // progress is printed at most once a second per job
+    QObject::connect(queue, &DownloadQueue::jobProgress, [&](int id, const ProgressEvent &ev) {
+        qint64 now = clock.elapsed();
+        if (now - lastPrint.value(id, -1000) < 1000) { return; }
+        lastPrint[id] = now;
+        out() << "[#" << id << "] " << ev.describe() << Qt::endl;
+    });
+
+    QObject::connect(queue, &DownloadQueue::jobFinished, [&](int id, int exitCode, JobState state) {
+        lastPrint.remove(id);
+        out() << "[#" << id << "] " << jobStateName(state) << " (exit code " << exitCode << ")" << Qt::endl;
+    });
+
+    auto summarize = [&] {
+        const DownloadManager::BatchStats &batch = downloads.batch();
+        out() << QString("Done: %1 completed, %2 failed, %3 canceled")
+                     .arg(batch.done).arg(batch.failed).arg(batch.canceled) << Qt::endl;
+        return batch.failed == 0 ? 0 : 1;
+    };
+
+    bool interrupted = false;
+    QObject::connect(&downloads, &DownloadManager::finished, &app, [&] {
+        int code = summarize();
+        app.exit(interrupted ? 130 : code);
+    });
+
+#ifdef Q_OS_UNIX
+    // first signal cancels everything and exits once the queue is idle, a second one quits at once
+    if (QSocketNotifier* notifier = watchTerminationSignals(&app))
+    {
+        QObject::connect(notifier, &QSocketNotifier::activated, &app, [&] {
+            if (interrupted)
+            {
+                app.exit(130);
+                return;
+            }
+            interrupted = true;
+            err() << "Interrupted, canceling downloads..." << Qt::endl;
+            downloads.cancelAll();
+        });
+    }
+#endif
+
+    if (parser.isSet("continue"))
+    {
+        if (!downloads.openJournal(DownloadManager::defaultJournalPath()))
+        {
+            // also when the window or another --continue run has it open
+            err() << "Could not open job journal (in use by another run?): "
+                  << DownloadManager::defaultJournalPath() << Qt::endl;
+            return 2;
+        }
+        downloads.resumeInterrupted();
+    }
+
+    for (const DownloadRequest &req : requests)
+    {
+        if (!isHttpUrl(req.url))
+        {
+            err() << "Skipping invalid URL: " << req.url << Qt::endl;
+            continue;
+        }
+        QDir().mkpath(req.outputDir);
+        downloads.submit(req);
+    }
+
+    // everything may have been skipped already
+    if (downloads.isIdle())
+        return summarize();
+
+    return app.exec();
+}
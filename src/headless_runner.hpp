@@ -0,0 +1,12 @@
+#ifndef HEADLESS_RUNNER_HPP
+#define HEADLESS_RUNNER_HPP
+
+#include <QCoreApplication>
+
+
+// "yt-dlp-GUI --headless ..." entry point: same queue, archive and
+// playlist handling as the window, driven from the command line.
+int runHeadless(QCoreApplication &app);
+
+
+#endif // HEADLESS_RUNNER_HPP
@@ -0,0 +1,187 @@
+#include "host_scheduler.hpp"
+
+#include <QUrl>
+#include <QDateTime>
+#include <QSet>
+
+
+// ---------- Helper functions ----------
+static qint64 now()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+static bool isThrottleLine(const QString &line)
+{
+    return line.contains("HTTP Error 429") || line.contains("Too Many Requests", Qt::CaseInsensitive);
+}
+
+
+// ---------- HostScheduler ----------
+HostScheduler::HostScheduler(DownloadQueue *queue, QObject *parent)
+    : QObject(parent), queue(queue)
+{
+    queue->setPicker([this](const QList<int> &pending) { return pick(pending); });
+    queue->addLaunchArgs([this](int id) { return launchArgs(id); });
+
+    connect(queue, &DownloadQueue::jobStarted, this, &HostScheduler::jobStarted);
+    connect(queue, &DownloadQueue::jobQueued, this, &HostScheduler::jobGone);
+    connect(queue, &DownloadQueue::jobFinished, this, [this](int id) { jobGone(id); });
+    connect(queue, &DownloadQueue::jobLines, this, &HostScheduler::jobLines);
+
+    tick.setInterval(30 * 1000);
+    connect(&tick, &QTimer::timeout, this, &HostScheduler::relax);
+    tick.start();
+}
+
+void HostScheduler::setMaxPerHost(int n)
+{
+    perHost = qMax(0, n);
+    queue->wake();
+}
+
+QString HostScheduler::siteOf(const QString &url)
+{
+    QString host = QUrl(url).host().toLower();
+    if (host == "youtu.be") { return "youtube.com"; }
+
+    // the registrable part: last two labels, three for "co.uk" and the like
+    QStringList labels = host.split('.', Qt::SkipEmptyParts);
+    int keep = 2;
+    if (labels.size() > 2 && labels.last().size() == 2
+        && QStringList{"co", "com", "net", "org", "ac", "gov", "edu", "ne", "or"}.contains(labels[labels.size() - 2]))
+        keep = 3;
+    if (labels.size() <= keep) { return host; }
+    return labels.mid(labels.size() - keep).join('.');
+}
+
+int HostScheduler::capFor(const Host &h) const
+{
+    if (h.level > 0) { return 1; }
+    return perHost;
+}
+
+
+// ---------- picking ----------
+int HostScheduler::pick(const QList<int> &pending)
+{
+    // first job of the least busy site that is under its cap, the site
+    // started longest ago wins a tie, so sites take turns
+    int best = -1;
+    Host bestHost;
+    QSet<QString> seen;
+
+    for (int i = 0; i < pending.size(); i++)
+    {
+        const DownloadJob* j = queue->job(pending[i]);
+        QString site = j ? siteOf(j->url) : QString();
+        if (seen.contains(site)) { continue; }
+        seen.insert(site);
+
+        Host h = hosts.value(site);
+        int cap = capFor(h);
+        if (cap > 0 && h.running >= cap) { continue; }
+
+        if (best < 0 || h.running < bestHost.running
+            || (h.running == bestHost.running && h.lastStartAt < bestHost.lastStartAt))
+        {
+            best = i;
+            bestHost = h;
+        }
+    }
+    return best;
+}
+
+QStringList HostScheduler::launchArgs(int id)
+{
+    const DownloadJob* j = queue->job(id);
+    if (!j) { return {}; }
+
+    int level = hosts.value(siteOf(j->url)).level;
+    if (level == 0) { return {}; }
+
+    // 1 s between requests and 2-5 s before the download at level 1, doubling per level
+    int scale = 1 << (level - 1);
+    return {"--sleep-requests", QString::number(scale),
+            "--sleep-interval", QString::number(2 * scale),
+            "--max-sleep-interval", QString::number(5 * scale)};
+}
+
+
+// ---------- bookkeeping ----------
+void HostScheduler::jobStarted(int id)
+{
+    const DownloadJob* j = queue->job(id);
+    if (!j) { return; }
+
+    QString site = siteOf(j->url);
+    Host &h = hosts[site];
+    h.running++;
+    h.lastStartAt = now();
+    runningSite.insert(id, site);
+}
+
+void HostScheduler::jobGone(int id)
+{
+    auto it = runningSite.find(id);
+    if (it == runningSite.end()) { return; }
+
+    Host &h = hosts[*it];
+    h.running = qMax(0, h.running - 1);
+    runningSite.erase(it);
+}
+
+void HostScheduler::jobLines(int id, const QStringList &lines)
+{
+    auto it = runningSite.constFind(id);
+    if (it == runningSite.constEnd()) { return; }
+
+    bool hit = false;
+    for (const QString &line : lines)
+        if (isThrottleLine(line)) { hit = true; break; }
+    if (!hit) { return; }
+
+    Host &h = hosts[*it];
+    qint64 t = now();
+
+    // several jobs report the same 429 burst, that is one step up
+    if (h.level > 0 && t - h.lastThrottleAt < 10 * 1000)
+    {
+        h.lastThrottleAt = t;
+        return;
+    }
+    h.lastThrottleAt = t;
+    if (h.level >= maxLevel) { return; }
+
+    h.level++;
+    emit throttled(*it, h.level);
+}
+
+void HostScheduler::relax()
+{
+    qint64 t = now();
+    bool changed = false;
+
+    for (auto it = hosts.begin(); it != hosts.end(); )
+    {
+        Host &h = it.value();
+        if (h.level > 0 && t - h.lastThrottleAt > calmMs)
+        {
+            h.level--;
+            h.lastThrottleAt = t;
+            changed = true;
+            if (h.level == 0)
+                emit recovered(it.key());
+        }
+
+        // forget idle sites that are not being paced
+        if (h.level == 0 && h.running == 0 && t - h.lastStartAt > calmMs)
+            it = hosts.erase(it);
+        else
+            ++it;
+    }
+
+    // a site back to full speed may take more jobs now
+    if (changed)
+        queue->wake();
+}
@@ -0,0 +1,68 @@
+#ifndef HOST_SCHEDULER_HPP
+#define HOST_SCHEDULER_HPP
+
+#include "download_queue.hpp"
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QString>
+
+
+// Keeps the queue polite per site. At most maxPerHost() yt-dlp processes
+// talk to one site at a time, the next job is taken from the site with
+// the fewest running (so a batch of one site doesn't starve the others),
+// and once a site answers 429 its jobs get --sleep-requests and
+// --sleep-interval, growing with every new 429 and easing off when the
+// site has been quiet for a while. A throttled site runs one job at a time.
+class HostScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HostScheduler(DownloadQueue *queue, QObject *parent = nullptr);
+
+    // 0 for no per-site cap
+    void setMaxPerHost(int n);
+    int maxPerHost() const { return perHost; }
+
+    // "www.youtube.com", "youtu.be" and "m.youtube.com" are one site
+    static QString siteOf(const QString &url);
+
+    int throttleLevel(const QString &site) const { return hosts.value(site).level; }
+    int runningOn(const QString &site) const { return hosts.value(site).running; }
+
+signals:
+    void throttled(const QString &site, int level);
+    void recovered(const QString &site);
+
+private:
+    struct Host
+    {
+        int running = 0;
+        int level = 0;            // 0 = not throttled
+        qint64 lastStartAt = 0;
+        qint64 lastThrottleAt = 0;
+    };
+
+    DownloadQueue* queue;
+    int perHost = 2;
+
+    QHash<QString, Host> hosts;
+    QHash<int, QString> runningSite;
+    QTimer tick;
+
+    int pick(const QList<int> &pending);
+    QStringList launchArgs(int id);
+    int capFor(const Host &h) const;
+
+    void jobStarted(int id);
+    void jobGone(int id);
+    void jobLines(int id, const QStringList &lines);
+    void relax();
+
+    static constexpr int maxLevel = 4;
+    static constexpr qint64 calmMs = 3 * 60 * 1000;
+};
+
+
+#endif // HOST_SCHEDULER_HPP
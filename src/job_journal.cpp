@@ -0,0 +1,273 @@
+#include "job_journal.hpp"
+
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QDebug>
+#include <algorithm>
+#include <utility>
+
+
+// ---------- Helper functions ----------
+static QByteArray line(const QJsonObject &o)
+{
+    return QJsonDocument(o).toJson(QJsonDocument::Compact) + '\n';
+}
+
+static QJsonObject enqueueEvent(const JournalEntry &e)
+{
+    return {{"e", "enqueue"}, {"uid", e.uid}, {"req", e.request}};
+}
+
+
+// ---------- JournalWriter ----------
+JournalWriter::JournalWriter(const QString &path)
+{
+    file.setFileName(path);
+}
+
+void JournalWriter::append(const QByteArray &lines)
+{
+    if (!file.isOpen() && !file.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qWarning() << "Could not open job journal:" << file.fileName();
+        return;
+    }
+
+    // flushed right away, a crash of the app must not lose the batch
+    file.write(lines);
+    file.flush();
+}
+
+void JournalWriter::rewrite(const QByteArray &contents)
+{
+    file.close();
+
+    QSaveFile out(file.fileName());
+    if (!out.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Could not compact job journal:" << file.fileName();
+        return;
+    }
+    out.write(contents);
+    out.commit();
+}
+
+
+// ---------- JobJournal ----------
+JobJournal::JobJournal(QObject *parent)
+    : QObject(parent)
+{
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(flushIntervalMs);
+    connect(&flushTimer, &QTimer::timeout, this, &JobJournal::flush);
+}
+
+JobJournal::~JobJournal()
+{
+    // the last batch is written before the thread is let go; a blocking call
+    // runs after everything queued earlier, so quit() cannot drop any of it
+    flushTimer.stop();
+    if (writer)
+    {
+        QByteArray rest = std::exchange(batch, {});
+        JournalWriter* w = writer;
+        QMetaObject::invokeMethod(writer, [w, rest] { w->append(rest); }, Qt::BlockingQueuedConnection);
+    }
+    thread.quit();
+    thread.wait();
+    delete writer;
+}
+
+QList<JournalEntry> JobJournal::replay(const QString &path, int &lines)
+{
+    QHash<QString, JournalEntry> entries;
+    QList<QString> order;
+    lines = 0;
+
+    QFile in(path);
+    if (!in.open(QIODevice::ReadOnly)) { return {}; }
+
+    while (!in.atEnd())
+    {
+        QByteArray raw = in.readLine();
+        lines++;
+
+        // a torn last line after a crash is not valid JSON
+        QJsonObject o = QJsonDocument::fromJson(raw).object();
+        QString uid = o.value("uid").toString();
+        QString event = o.value("e").toString();
+        if (uid.isEmpty()) { continue; }
+
+        if (event == "enqueue")
+        {
+            JournalEntry e;
+            e.uid = uid;
+            e.seq = order.size();
+            e.request = o.value("req").toObject();
+            entries.insert(uid, e);
+            order << uid;
+        }
+        else if (event == "start" && entries.contains(uid))
+        {
+            entries[uid].started = true;
+        }
+        else if (event == "progress" && entries.contains(uid))
+        {
+            entries[uid].bytes = o.value("bytes").toInteger();
+        }
+        else if (event == "finish")
+        {
+            entries.remove(uid);
+        }
+    }
+
+    QList<JournalEntry> result;
+    for (const QString &uid : order)
+        if (entries.contains(uid))
+            result << entries.value(uid);
+    return result;
+}
+
+bool JobJournal::open(const QString &path)
+{
+    filePath = path;
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    // a lock left by a process that is gone is taken over by tryLock()
+    lock = std::make_unique<QLockFile>(path + ".lock");
+    lock->setStaleLockTime(0);
+    if (!lock->tryLock())
+    {
+        if (lock->error() == QLockFile::LockFailedError)
+            qWarning() << "Job journal is in use by another process:" << path;
+        else
+            qWarning() << "Could not lock job journal:" << path;
+        return false;
+    }
+
+    leftOver = replay(path, fileLines);
+    for (const JournalEntry &e : std::as_const(leftOver))
+        live.insert(e.uid, e);
+    nextSeq = leftOver.size();
+
+    // compacted down to the unfinished jobs before anything new is written
+    QByteArray contents = snapshot();
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly) || out.write(contents) != contents.size() || !out.commit())
+    {
+        qWarning() << "Could not open job journal:" << path;
+        return false;
+    }
+    fileLines = contents.count('\n');
+
+    writer = new JournalWriter(path);
+    writer->moveToThread(&thread);
+    connect(this, &JobJournal::writeLines, writer, &JournalWriter::append);
+    connect(this, &JobJournal::rewriteFile, writer, &JournalWriter::rewrite);
+    thread.setObjectName("JobJournal");
+    thread.start(QThread::LowPriority);
+
+    return true;
+}
+
+
+// ---------- events ----------
+void JobJournal::enqueued(const QString &uid, const QJsonObject &request)
+{
+    JournalEntry e;
+    e.uid = uid;
+    e.seq = nextSeq++;
+    e.request = request;
+    live.insert(uid, e);
+
+    write(enqueueEvent(e));
+}
+
+void JobJournal::started(const QString &uid)
+{
+    auto it = live.find(uid);
+    if (it == live.end()) { return; }
+
+    it->started = true;
+    write({{"e", "start"}, {"uid", uid}});
+}
+
+void JobJournal::checkpoint(const QString &uid, qint64 bytes)
+{
+    auto it = live.find(uid);
+    if (it == live.end()) { return; }
+    it->bytes = bytes;
+
+    // progress comes many times a second, the journal only needs a hint
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (now - lastCheckpoint.value(uid, 0) < checkpointIntervalMs) { return; }
+    lastCheckpoint[uid] = now;
+
+    write({{"e", "progress"}, {"uid", uid}, {"bytes", bytes}});
+}
+
+void JobJournal::finished(const QString &uid, const QString &state)
+{
+    live.remove(uid);
+    lastCheckpoint.remove(uid);
+
+    write({{"e", "finish"}, {"uid", uid}, {"state", state}});
+}
+
+
+// ---------- writing ----------
+void JobJournal::write(const QJsonObject &event)
+{
+    if (!writer) { return; }
+
+    batch += line(event);
+    fileLines++;
+
+    if (batch.size() >= maxBatchBytes)
+        flush();
+    else if (!flushTimer.isActive())
+        flushTimer.start();
+}
+
+void JobJournal::flush()
+{
+    flushTimer.stop();
+    if (batch.isEmpty()) { return; }
+
+    emit writeLines(batch);
+    batch.clear();
+
+    maybeCompact();
+}
+
+void JobJournal::maybeCompact()
+{
+    // mostly finished jobs and old checkpoints by now
+    if (fileLines < 4 * live.size() + 2000) { return; }
+
+    QByteArray contents = snapshot();
+    fileLines = contents.count('\n');
+    emit rewriteFile(contents);
+}
+
+QByteArray JobJournal::snapshot() const
+{
+    QList<JournalEntry> entries = live.values();
+    std::sort(entries.begin(), entries.end(), [](const JournalEntry &a, const JournalEntry &b) {
+        return a.seq < b.seq;
+    });
+
+    QByteArray out;
+    for (const JournalEntry &e : entries)
+    {
+        out += line(enqueueEvent(e));
+        if (e.started)
+            out += line({{"e", "start"}, {"uid", e.uid}});
+        if (e.bytes > 0)
+            out += line({{"e", "progress"}, {"uid", e.uid}, {"bytes", e.bytes}});
+    }
+    return out;
+}
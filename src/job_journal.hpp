@@ -0,0 +1,105 @@
+#ifndef JOB_JOURNAL_HPP
+#define JOB_JOURNAL_HPP
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QHash>
+#include <QList>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+#include <QLockFile>
+#include <memory>
+
+
+struct JournalEntry
+{
+    QString uid;
+    int seq = 0;             // enqueue order, kept across compactions
+    QJsonObject request;     // DownloadRequest::toJson()
+    bool started = false;
+    qint64 bytes = 0;        // last progress checkpoint
+};
+
+// Owns the journal file on the writer thread; everything reaches it
+// through queued signals, so writes keep the order they were made in.
+class JournalWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JournalWriter(const QString &path);
+
+    void append(const QByteArray &lines);
+    void rewrite(const QByteArray &contents);
+
+private:
+    QFile file;
+};
+
+// Write-ahead log of job events, one JSON object per line:
+//   {"e":"enqueue","uid":...,"req":{...}}  {"e":"start","uid":...}
+//   {"e":"progress","uid":...,"bytes":n}   {"e":"finish","uid":...,"state":...}
+// Lines are batched on the GUI thread and written by a worker thread a few
+// times a second. Replaying it on startup yields the jobs that never
+// finished; the file is compacted down to those whenever it grows.
+// A lock file next to it keeps a second process from replaying or
+// appending to the same journal.
+class JobJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JobJournal(QObject *parent = nullptr);
+    ~JobJournal() override;
+
+    // replays and compacts the file, then starts the writer; fails while
+    // another process holds the journal
+    bool open(const QString &path);
+    QString path() const { return filePath; }
+
+    // jobs that were queued or running when the app last exited; they stay
+    // in the journal until the caller marks them finished
+    QList<JournalEntry> interrupted() const { return leftOver; }
+
+    void enqueued(const QString &uid, const QJsonObject &request);
+    void started(const QString &uid);
+    void checkpoint(const QString &uid, qint64 bytes);
+    void finished(const QString &uid, const QString &state);
+
+    void flush();
+
+signals:
+    void writeLines(const QByteArray &lines);
+    void rewriteFile(const QByteArray &contents);
+
+private:
+    QString filePath;
+    std::unique_ptr<QLockFile> lock;
+    QThread thread;
+    JournalWriter* writer = nullptr;
+
+    QByteArray batch;
+    QTimer flushTimer;
+
+    QHash<QString, JournalEntry> live;
+    QHash<QString, qint64> lastCheckpoint;
+    QList<JournalEntry> leftOver;
+    int fileLines = 0;
+    int nextSeq = 0;
+
+    void write(const QJsonObject &event);
+    void maybeCompact();
+    QByteArray snapshot() const;
+
+    static QList<JournalEntry> replay(const QString &path, int &lines);
+
+    static constexpr int flushIntervalMs = 250;
+    static constexpr int maxBatchBytes = 64 * 1024;
+    static constexpr qint64 checkpointIntervalMs = 5000;
+};
+
+
+#endif // JOB_JOURNAL_HPP
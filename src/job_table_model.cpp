@@ -0,0 +1,246 @@
+#include "job_table_model.hpp"
+#include "host_scheduler.hpp"
+
+#include <algorithm>
+
+
+// ---------- Helper functions ----------
+static QString formatEta(int seconds)
+{
+    if (seconds < 0) { return {}; }
+    if (seconds >= 3600)
+        return QString("%1:%2:%3").arg(seconds / 3600).arg(seconds / 60 % 60, 2, 10, QChar('0')).arg(seconds % 60, 2, 10, QChar('0'));
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
+
+
+// ---------- JobTableModel ----------
+JobTableModel::JobTableModel(DownloadQueue *queue, PostProcessor *post, QObject *parent)
+    : QAbstractTableModel(parent), queue(queue), post(post)
+{
+    frameTimer.setSingleShot(true);
+    setFrameRate(10);
+    connect(&frameTimer, &QTimer::timeout, this, &JobTableModel::flushFrame);
+
+    connect(queue, &DownloadQueue::jobQueued, this, &JobTableModel::jobQueued);
+    connect(queue, &DownloadQueue::jobStarted, this, &JobTableModel::jobStarted);
+    connect(queue, &DownloadQueue::jobProgress, this, &JobTableModel::jobProgress);
+    connect(queue, &DownloadQueue::jobFinished, this, &JobTableModel::jobFinished);
+
+    connect(post, &PostProcessor::taskStarted, this, [this](int id) { setState(id, "converting"); });
+    connect(post, &PostProcessor::taskFinished, this, [this](int id, bool ok) {
+        setState(id, ok ? "finished" : "failed");
+    });
+
+    // jobs queued before the model existed
+    const QList<int> ids = queue->jobIds();
+    for (int id : ids)
+    {
+        jobQueued(id);
+        if (const DownloadJob* j = queue->job(id))
+            setState(id, jobStateName(j->state));
+    }
+}
+
+void JobTableModel::setFrameRate(int fps)
+{
+    frameTimer.setInterval(1000 / qBound(1, fps, 60));
+}
+
+int JobTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows.size();
+}
+
+int JobTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant JobTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rows.size()) { return {}; }
+    const Row &r = rows[index.row()];
+
+    if (role == SortRole)
+    {
+        switch (index.column())
+        {
+            case Id: return r.id;
+            case State: return r.state;
+            case Site: return r.site;
+            case Url: return r.url;
+            case Progress: return r.percent;
+            case Speed: return r.speed;
+            case Eta: return r.eta;
+            case Size: return r.total;
+        }
+        return {};
+    }
+
+    if (role == Qt::TextAlignmentRole && index.column() != Url && index.column() != Site)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+
+    if (role != Qt::DisplayRole) { return {}; }
+
+    switch (index.column())
+    {
+        case Id: return r.id;
+        case State: return r.state;
+        case Site: return r.site;
+        case Url: return r.url;
+        case Progress: return r.percent < 0 ? QString() : QString("%1%").arg(r.percent, 0, 'f', 1);
+        case Speed: return r.speed <= 0 ? QString() : formatBytes(r.speed) + "/s";
+        case Eta: return formatEta(r.eta);
+        case Size: return r.total < 0 ? QString() : formatBytes(r.total);
+    }
+    return {};
+}
+
+QVariant JobTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) { return {}; }
+
+    static const char *names[] = {"#", "State", "Site", "URL", "Progress", "Speed", "ETA", "Size"};
+    return (section >= 0 && section < ColumnCount) ? QString(names[section]) : QVariant();
+}
+
+
+// ---------- updates ----------
+JobTableModel::Row* JobTableModel::rowFor(int id)
+{
+    auto it = rowOf.constFind(id);
+    return it == rowOf.constEnd() ? nullptr : &rows[it.value()];
+}
+
+void JobTableModel::markDirty(int row)
+{
+    dirty.insert(row);
+    if (!frameTimer.isActive())
+        frameTimer.start();
+}
+
+void JobTableModel::flushFrame()
+{
+    if (dirty.isEmpty()) { return; }
+
+    QList<int> changed(dirty.begin(), dirty.end());
+    dirty.clear();
+    std::sort(changed.begin(), changed.end());
+
+    // one signal per run of neighbouring rows
+    int first = changed.first();
+    int last = first;
+    for (int i = 1; i <= changed.size(); i++)
+    {
+        if (i < changed.size() && changed[i] == last + 1)
+        {
+            last = changed[i];
+            continue;
+        }
+        emit dataChanged(index(first, 0), index(last, ColumnCount - 1));
+        if (i < changed.size())
+            first = last = changed[i];
+    }
+}
+
+void JobTableModel::jobQueued(int id)
+{
+    // a requeue (restart, retry) is the same row again
+    if (rowOf.contains(id))
+    {
+        setState(id, "queued");
+        return;
+    }
+
+    const DownloadJob* j = queue->job(id);
+    Row r;
+    r.id = id;
+    r.url = j ? j->url : QString();
+    r.site = HostScheduler::siteOf(r.url);
+
+    int row = rows.size();
+    beginInsertRows(QModelIndex(), row, row);
+    rows << r;
+    rowOf.insert(id, row);
+    endInsertRows();
+}
+
+void JobTableModel::jobStarted(int id)
+{
+    setState(id, "running");
+}
+
+void JobTableModel::jobProgress(int id, const ProgressEvent &ev)
+{
+    Row* r = rowFor(id);
+    if (!r || ev.kind != ProgressEvent::Kind::Download) { return; }
+
+    r->percent = ev.percent();
+    r->speed = ev.speed;
+    r->eta = ev.eta;
+    r->downloaded = ev.downloadedBytes;
+    if (ev.totalBytes > 0)
+        r->total = ev.totalBytes;
+    markDirty(rowOf.value(id));
+}
+
+void JobTableModel::jobFinished(int id, int, JobState state)
+{
+    Row* r = rowFor(id);
+    if (!r) { return; }
+
+    r->speed = -1;
+    r->eta = -1;
+    if (state == JobState::Finished)
+        r->percent = 100;
+
+    // audio jobs go on in the ffmpeg pool
+    if (state == JobState::Finished && post->isQueued(id))
+        setState(id, "converting");
+    else
+        setState(id, jobStateName(state));
+}
+
+void JobTableModel::setState(int id, const QString &state)
+{
+    Row* r = rowFor(id);
+    if (!r || r->state == state) { return; }
+
+    r->state = state;
+    markDirty(rowOf.value(id));
+}
+
+
+// ---------- JobFilterModel ----------
+JobFilterModel::JobFilterModel(QObject *parent)
+    : QSortFilterProxyModel(parent)
+{
+    setSortRole(JobTableModel::SortRole);
+    setDynamicSortFilter(true);
+}
+
+void JobFilterModel::setStateFilter(const QString &s)
+{
+    state = s;
+    invalidateFilter();
+}
+
+void JobFilterModel::setTextFilter(const QString &t)
+{
+    text = t.trimmed();
+    invalidateFilter();
+}
+
+bool JobFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    QAbstractItemModel* m = sourceModel();
+    int role = JobTableModel::SortRole;
+
+    if (!state.isEmpty() && m->index(sourceRow, JobTableModel::State, sourceParent).data(role).toString() != state)
+        return false;
+    if (text.isEmpty()) { return true; }
+
+    return m->index(sourceRow, JobTableModel::Site, sourceParent).data(role).toString().contains(text, Qt::CaseInsensitive)
+        || m->index(sourceRow, JobTableModel::Url, sourceParent).data(role).toString().contains(text, Qt::CaseInsensitive);
+}
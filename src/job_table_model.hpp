@@ -0,0 +1,93 @@
+#ifndef JOB_TABLE_MODEL_HPP
+#define JOB_TABLE_MODEL_HPP
+
+#include "download_queue.hpp"
+#include "post_processor.hpp"
+#include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+
+
+// One row per job, kept as a small copy of what the columns show. Progress
+// only marks rows dirty; dataChanged goes out once per frame for each run
+// of dirty rows, so thousands of jobs cost the view nothing but the rows
+// it actually paints.
+class JobTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { Id, State, Site, Url, Progress, Speed, Eta, Size, ColumnCount };
+
+    // raw values for sorting and filtering, Qt::DisplayRole is formatted
+    static constexpr int SortRole = Qt::UserRole;
+
+    JobTableModel(DownloadQueue *queue, PostProcessor *post, QObject *parent = nullptr);
+
+    void setFrameRate(int fps);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    int jobAt(int row) const { return rows.value(row).id; }
+
+private:
+    struct Row
+    {
+        int id = 0;
+        QString url;
+        QString site;
+        QString state = "queued";
+        double percent = -1;
+        double speed = -1;
+        int eta = -1;
+        qint64 downloaded = -1;
+        qint64 total = -1;
+    };
+
+    DownloadQueue* queue;
+    PostProcessor* post;
+    QVector<Row> rows;
+    QHash<int, int> rowOf;
+    QSet<int> dirty;
+    QTimer frameTimer;
+
+    Row* rowFor(int id);
+    void markDirty(int row);
+    void flushFrame();
+
+    void jobQueued(int id);
+    void jobStarted(int id);
+    void jobProgress(int id, const ProgressEvent &ev);
+    void jobFinished(int id, int exitCode, JobState state);
+    void setState(int id, const QString &state);
+};
+
+// State and text filters on top of the model; the text matches the site
+// or the URL. Sorting uses the model's raw values.
+class JobFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit JobFilterModel(QObject *parent = nullptr);
+
+    // empty for every state
+    void setStateFilter(const QString &state);
+    void setTextFilter(const QString &text);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    QString state;
+    QString text;
+};
+
+
+#endif // JOB_TABLE_MODEL_HPP
@@ -0,0 +1,176 @@
+#include "local_http_server.hpp"
+
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QDebug>
+
+
+// ---------- Helper functions ----------
+static QByteArray reasonPhrase(int status)
+{
+    switch (status)
+    {
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 403: return "Forbidden";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 409: return "Conflict";
+        case 413: return "Payload Too Large";
+        case 415: return "Unsupported Media Type";
+        case 500: return "Internal Server Error";
+    }
+    return "Unknown";
+}
+
+// false while the request is still incomplete
+static bool parseRequest(const QByteArray &data, HttpRequest &req, bool &malformed)
+{
+    malformed = false;
+    int end = data.indexOf("\r\n\r\n");
+    if (end < 0) { return false; }
+
+    const QList<QByteArray> lines = data.left(end).split('\n');
+    const QList<QByteArray> start = lines.value(0).trimmed().split(' ');
+    if (start.size() != 3)
+    {
+        malformed = true;
+        return true;
+    }
+
+    req.method = start[0];
+    QByteArray target = start[1];
+    int q = target.indexOf('?');
+    req.path = q < 0 ? target : target.left(q);
+    req.query = q < 0 ? QByteArray() : target.mid(q + 1);
+
+    for (int i = 1; i < lines.size(); i++)
+    {
+        int colon = lines[i].indexOf(':');
+        if (colon <= 0) { continue; }
+        req.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+    }
+
+    bool ok = true;
+    qint64 length = req.headers.value("content-length", "0").toLongLong(&ok);
+    if (!ok || length < 0)
+    {
+        malformed = true;
+        return true;
+    }
+    if (data.size() - (end + 4) < length) { return false; }
+
+    req.body = data.mid(end + 4, length);
+    return true;
+}
+
+
+// ---------- LocalHttpServer ----------
+LocalHttpServer::LocalHttpServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&server, &QTcpServer::newConnection, this, &LocalHttpServer::accept);
+}
+
+void LocalHttpServer::addRoute(const QByteArray &method, const QByteArray &path, Handler handler)
+{
+    routes.insert(method + ' ' + path, std::move(handler));
+}
+
+bool LocalHttpServer::listen(quint16 port)
+{
+    if (server.isListening())
+        server.close();
+
+    if (!server.listen(QHostAddress::LocalHost, port))
+    {
+        qWarning() << "Could not listen on 127.0.0.1:" << port << server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void LocalHttpServer::accept()
+{
+    while (QTcpSocket* socket = server.nextPendingConnection())
+    {
+        buffers.insert(socket, {});
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket] { readRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+            buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void LocalHttpServer::readRequest(QTcpSocket *socket)
+{
+    // anything after the request is ignored, the connection is closing
+    auto buf = buffers.find(socket);
+    if (buf == buffers.end())
+    {
+        socket->readAll();
+        return;
+    }
+    QByteArray &data = *buf;
+    data += socket->readAll();
+
+    if (data.size() > maxRequestBytes)
+    {
+        respond(socket, {413, "text/plain; charset=utf-8", "request too large\n"});
+        return;
+    }
+
+    HttpRequest req;
+    bool malformed = false;
+    if (!parseRequest(data, req, malformed)) { return; }
+    if (malformed)
+    {
+        respond(socket, {400, "text/plain; charset=utf-8", "bad request\n"});
+        return;
+    }
+
+    // a DNS rebinding page reaches the same socket under its own host name
+    QByteArray port = QByteArray::number(server.serverPort());
+    QByteArray host = req.headers.value("host").toLower();
+    if (host != "127.0.0.1:" + port && host != "localhost:" + port)
+    {
+        respond(socket, {403, "text/plain; charset=utf-8", "forbidden host\n"});
+        return;
+    }
+
+    auto it = routes.constFind(req.method + ' ' + req.path);
+    if (it != routes.constEnd())
+    {
+        respond(socket, (*it)(req));
+        return;
+    }
+
+    // tell a wrong method apart from a wrong path
+    for (auto r = routes.constBegin(); r != routes.constEnd(); ++r)
+    {
+        if (r.key().endsWith(' ' + req.path))
+        {
+            respond(socket, {405, "text/plain; charset=utf-8", "method not allowed\n"});
+            return;
+        }
+    }
+    respond(socket, {404, "text/plain; charset=utf-8", "not found\n"});
+}
+
+void LocalHttpServer::respond(QTcpSocket *socket, const HttpResponse &response)
+{
+    buffers.remove(socket);
+
+    QByteArray head = "HTTP/1.1 " + QByteArray::number(response.status) + ' ' + reasonPhrase(response.status) + "\r\n"
+                      "Content-Type: " + response.contentType + "\r\n"
+                      "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n"
+                      "Cache-Control: no-store\r\n"
+                      "Connection: close\r\n\r\n";
+    socket->write(head);
+    socket->write(response.body);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,62 @@
+#ifndef LOCAL_HTTP_SERVER_HPP
+#define LOCAL_HTTP_SERVER_HPP
+
+#include <QObject>
+#include <QTcpServer>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+class QTcpSocket;
+
+
+struct HttpRequest
+{
+    QByteArray method;
+    QByteArray path;     // without the query
+    QByteArray query;
+    QHash<QByteArray, QByteArray> headers;   // names lowercased
+    QByteArray body;
+};
+
+struct HttpResponse
+{
+    int status = 200;
+    QByteArray contentType = "text/plain; charset=utf-8";
+    QByteArray body;
+};
+
+// Minimal HTTP/1.1 server bound to 127.0.0.1, one response per
+// connection. Enough for scrapers and scripts on the same machine; it is
+// never exposed on other interfaces, and requests whose Host is not
+// 127.0.0.1:<port> or localhost:<port> are refused.
+class LocalHttpServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest &)>;
+
+    explicit LocalHttpServer(QObject *parent = nullptr);
+
+    void addRoute(const QByteArray &method, const QByteArray &path, Handler handler);
+
+    bool listen(quint16 port);
+    quint16 port() const { return server.serverPort(); }
+    bool isListening() const { return server.isListening(); }
+
+private:
+    QTcpServer server;
+    QHash<QByteArray, Handler> routes;   // "GET /metrics"
+    QHash<QTcpSocket*, QByteArray> buffers;
+
+    void accept();
+    void readRequest(QTcpSocket *socket);
+    void respond(QTcpSocket *socket, const HttpResponse &response);
+
+    static constexpr int maxRequestBytes = 1024 * 1024;
+};
+
+
+#endif // LOCAL_HTTP_SERVER_HPP
@@ -1,20 +1,124 @@
 #include <QApplication>
 #include <QFile>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QDebug>
+#include <QSettings>
 #include "main_window.hpp"
+#include "headless_runner.hpp"
+#include "benchmark.hpp"
 #include "resources/style_loader.hpp"
+#include "resources/theme_engine.hpp"
+#include "startup_trace.hpp"
+#include "single_instance.hpp"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <cstdio>
+#endif
+
+static bool hasFlag(int argc, char *argv[], const char *flag)
+{
+    for (int i = 1; i < argc; i++)
+        if (qstrcmp(argv[i], flag) == 0) { return true; }
+    return false;
+}
+
+// cold start to a window that takes input, slower starts are warned about
+static constexpr qint64 startupTargetMs = 500;
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
+    StartupTrace::begin();
+
+    // no QApplication, so no display server is needed
+    if (hasFlag(argc, argv, "--headless"))
+    {
+#ifdef Q_OS_WIN
+        // the release is a GUI subsystem binary and starts without a console
+        if (AttachConsole(ATTACH_PARENT_PROCESS))
+        {
+            freopen("CONOUT$", "w", stdout);
+            freopen("CONOUT$", "w", stderr);
+        }
+#endif
+        QCoreApplication app(argc, argv);
+
+        QCoreApplication::setOrganizationName("yt-dlp-gui");
+        QCoreApplication::setApplicationName("yt-dlp-gui");
+
+        return runHeadless(app);
+    }
+
+    // widgets are needed for the console, but not a display
+    if (hasFlag(argc, argv, "--bench"))
+    {
+        if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
+        QApplication app(argc, argv);
+
+        QCoreApplication::setOrganizationName("yt-dlp-gui");
+        QCoreApplication::setApplicationName("yt-dlp-gui");
+
+        return runBenchmark(app);
+    }
+
     QApplication app(argc, argv);
 
     QCoreApplication::setOrganizationName("yt-dlp-gui");
     QCoreApplication::setApplicationName("yt-dlp-gui");
+    StartupTrace::mark("application created");
+
+    // a second launch hands its URLs to the window already open
+    QStringList launchUrls;
+    const QStringList args = app.arguments().mid(1);
+    for (const QString &arg : args)
+        if (isHttpUrl(arg)) { launchUrls << arg; }
+
+    SingleInstance instance;
+    bool single = QSettings().value("single_instance", true).toBool();
+    if (single)
+    {
+        if (instance.forward(launchUrls)) { return 0; }
+        instance.listen();
+        StartupTrace::mark("single instance checked");
+    }
 
-    app.setStyleSheet(loadStyleSheet(Theme::Dark));
-    app.setWindowIcon(QIcon(":/icons/taskbar_icon.png"));
+    // "theme" may name a user theme from the themes folder; set before any
+    // widget exists, so each one is polished once when it is first shown
+    ThemeEngine &themes = ThemeEngine::instance();
+    themes.loadUserThemes(ThemeEngine::userThemesDir());
+    QString themeName = QSettings().value("theme", "dark").toString();
+    app.setStyleSheet(themes.hasTheme(themeName) ? themes.render(themeName) : loadStyleSheet(Theme::Dark));
+    StartupTrace::mark("stylesheet rendered");
 
     MainWindow w;
     w.show();
+    StartupTrace::mark("window shown");
+
+    QObject::connect(&instance, &SingleInstance::received, &w, &MainWindow::openUrls);
+
+    // the window can take input from its first frame on, the taskbar icon
+    // is decoded after it
+    QObject::connect(&w, &MainWindow::firstPainted, &w, [&startup, &w, launchUrls] {
+        QTimer::singleShot(0, qApp, [&w, launchUrls] {
+            qApp->setWindowIcon(QIcon(":/icons/taskbar_icon.png"));
+            StartupTrace::mark("taskbar icon decoded");
+
+            // after the journal is open, so they survive a crash too
+            if (!launchUrls.isEmpty())
+                w.openUrls(launchUrls);
+        });
+
+        qint64 ms = startup.elapsed();
+        if (ms > startupTargetMs)
+            qWarning().noquote() << QString("Startup took %1 ms (target %2 ms)").arg(ms).arg(startupTargetMs);
+        else
+            qInfo().noquote() << QString("Startup took %1 ms").arg(ms);
+    });
 
     return app.exec();
 }
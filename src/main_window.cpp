@@ -1,4 +1,7 @@
 #include "main_window.hpp"
+#include "metrics_dashboard.hpp"
+#include "queue_view.hpp"
+#include "startup_trace.hpp"
 
 #include <QApplication>
 #include <QLabel>
@@ -8,8 +11,6 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QDir>
-#include <QTextCursor>
-#include <QScrollBar>
 #include <QRegularExpression>
 #include <QButtonGroup>
 #include <QString>
@@ -20,6 +21,16 @@
 #include <QSettings>
 #include <QDateTime>
 #include <QTimer>
+#include <QStandardPaths>
+#include <QTabWidget>
+#include <QStatusBar>
+#include <QShortcut>
+#include <QClipboard>
+#include <QMimeData>
+#include <QDragEnterEvent>
+#include <QDropEvent>
+#include <QElapsedTimer>
+#include <QFile>
 
 
 #ifdef Q_OS_WIN
@@ -28,20 +39,6 @@
 
 
 // ---------- Helper functions ----------
-void MainWindow::sanitizeFilename(QString &s)
-{
-    static const QRegularExpression re(R"([\\/:\*\?\"<>\|])");
-    s.replace(re, "_");
-    s = s.trimmed();
-    if (s.size() > 100) s = s.left(100);
-}
-
-bool MainWindow::isPlaylistUrl(const QString &url)
-{
-    static const QRegularExpression re(R"(([\?&])list=)");
-    return re.match(url).hasMatch();
-}
-
 bool MainWindow::shouldUpdateYtDlp()
 {
     QSettings s;
@@ -54,11 +51,14 @@ bool MainWindow::shouldUpdateYtDlp()
     return (now - last > interval);
 }
 
-void MainWindow::updateYtDlpAsync()
+void MainWindow::updateYtDlpAsync(std::function<void()> done)
 {
-    // checks existence
-    QFileInfo fi(ytDlpPath);
-    if (!fi.exists() || !fi.isExecutable()) { return; }
+    if (!deps->ytDlp().usable())
+    {
+        if (done)
+            done();
+        return;
+    }
 
     QProcess* updater = new QProcess(this);
 
@@ -80,6 +80,9 @@ void MainWindow::updateYtDlpAsync()
 
                 QSettings s;
                 s.setValue("yt_dlp_last_update", QDateTime::currentSecsSinceEpoch());
+
+                // a new binary has a new mtime, so its version is probed again
+                deps->check();
             }
             else
             {
@@ -87,6 +90,8 @@ void MainWindow::updateYtDlpAsync()
             }
 
             updater->deleteLater();
+            if (done)
+                done();
         });
 
     log->append("Checking for yt-dlp updates...");
@@ -95,9 +100,11 @@ void MainWindow::updateYtDlpAsync()
 
 bool MainWindow::ensureYtDlp()
 {
-    // checks existence
-    QFileInfo fi(ytDlpPath);
-    if (!fi.exists() || !fi.isExecutable())
+    // the cached check is redone once in case the binary was added since
+    if (!deps->ytDlp().usable())
+        deps->check();
+
+    if (!deps->ytDlp().usable())
     {
         QMessageBox::critical(this, "Error", "yt-dlp not found or not executable on releases/deps.");
         return false;
@@ -108,9 +115,10 @@ bool MainWindow::ensureYtDlp()
 
 bool MainWindow::ensureFfmpeg()
 {
-    // checks existence
-    QFileInfo fi(ffmpegPath);
-    if (!fi.exists() || !fi.isExecutable())
+    if (!deps->ffmpeg().usable())
+        deps->check();
+
+    if (!deps->ffmpeg().usable())
     {
         QMessageBox::critical(this, "Error", "ffmpeg not found or not executable on releases/deps.");
         return false;
@@ -136,8 +144,17 @@ void MainWindow::applyInterFont(void)
 void MainWindow::switchTheme(Theme theme)
 {
     current_theme = theme;
-    qApp->setStyleSheet(loadStyleSheet(theme));
 
+    // rendered once per theme; re-applying the same sheet would still re-polish every widget
+    QString sheet = loadStyleSheet(theme);
+    if (qApp->styleSheet() != sheet)
+        qApp->setStyleSheet(sheet);
+
+    applyThemeIcons();
+}
+
+void MainWindow::applyThemeIcons()
+{
     if (current_theme == Theme::Dark)
     {
         dark_mode->setIcon(QIcon(":/icons/moon_dark.png"));
@@ -159,7 +176,6 @@ MainWindow::MainWindow(QWidget *parent)
     setFixedSize(size());
 
     this->setObjectName("MainWindow");
-    this->applyInterFont();
 
     QWidget *central = new QWidget(this);
     setCentralWidget(central);
@@ -169,7 +185,7 @@ MainWindow::MainWindow(QWidget *parent)
     QLabel *lblUrl = new QLabel("URL");
     lblUrl->setObjectName("Label");
     leUrl = new QLineEdit;
-    leUrl->setPlaceholderText("https://...");
+    leUrl->setPlaceholderText("https://... (separate multiple URLs with spaces)");
     leUrl->setFixedWidth(750);
     leUrl->setAlignment(Qt::AlignLeft);
 
@@ -205,7 +221,6 @@ MainWindow::MainWindow(QWidget *parent)
     dark_mode->setChecked(true);
     dark_mode->setFixedSize(35, 35);
     dark_mode->setObjectName("ColorModeButton");
-    dark_mode->setIcon(QIcon(":/icons/moon_dark.png"));
     dark_mode->setIconSize(QSize(18, 18));
     colors_group->addButton(dark_mode);
     colors_mode_layout->addWidget(dark_mode);
@@ -215,7 +230,6 @@ MainWindow::MainWindow(QWidget *parent)
     light_mode->setChecked(false);
     light_mode->setFixedSize(35, 35);
     light_mode->setObjectName("ColorModeButton");
-    light_mode->setIcon(QIcon(":/icons/sun_dark.png"));
     light_mode->setIconSize(QSize(18, 18));
     colors_group->addButton(light_mode);
     colors_mode_layout->addWidget(light_mode);
@@ -360,11 +374,28 @@ MainWindow::MainWindow(QWidget *parent)
     btnDownload->setObjectName("DownloadButton");
     btnDownload->setFixedSize(110, 35);
 
+    QLabel *lblParallel = new QLabel("Parallel");
+    lblParallel->setObjectName("Label");
+    sbParallel = new QSpinBox;
+    sbParallel->setRange(1, 16);
+    sbParallel->setFixedSize(70, 35);
+    sbParallel->setValue(QSettings().value("max_parallel_downloads", 3).toInt());
+
     connect(btnHelp, &QPushButton::clicked, this, &MainWindow::showHelp);
     connect(btnCancel, &QPushButton::clicked, this, &MainWindow::cancelDownload);
     connect(btnDownload, &QPushButton::clicked, this, &MainWindow::startDownload);
 
+    // bulk ingestion: paste anywhere with Ctrl+Shift+V, or drop text and files
+    QShortcut* pasteUrls = new QShortcut(QKeySequence("Ctrl+Shift+V"), this);
+    connect(pasteUrls, &QShortcut::activated, this, [=] {
+        ingestMime(QApplication::clipboard()->mimeData());
+    });
+    setAcceptDrops(true);
+
     QHBoxLayout *buttonsLayout = new QHBoxLayout;
+    buttonsLayout->addWidget(lblParallel);
+    buttonsLayout->addWidget(sbParallel);
+    buttonsLayout->addSpacing(20);
     buttonsLayout->addWidget(btnHelp);
     buttonsLayout->addWidget(btnCancel);
     buttonsLayout->addWidget(btnDownload);
@@ -377,15 +408,39 @@ MainWindow::MainWindow(QWidget *parent)
 
 
     // --- log ---
-    log = new QTextEdit;
-    log->setReadOnly(true);
-    log->setMinimumHeight(200);
-    QLabel* console_label = new QLabel("Console output");
-    console_label->setObjectName("Label");
+    logView = new QPlainTextEdit;
+    logView->setReadOnly(true);
+    logView->setMinimumHeight(200);
+    logView->setUndoRedoEnabled(false);
+
+    QSettings settings;
+    log = new ConsoleLog(logView, this);
+    log->setLimits(settings.value("log_max_lines", 5000).toInt(),
+                   settings.value("log_max_bytes", 4 * 1024 * 1024).toLongLong());
+    if (settings.value("log_spill_to_file", false).toBool())
+    {
+        QString logDir = QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation);
+        log->setSpillFile(QDir(logDir).filePath("logs/console.log"));
+    }
+    // console and metrics share the space below the controls
+    QTabWidget* outputTabs = new QTabWidget;
+    outputTabs->addTab(logView, "Console output");
+
+    // --- progress ---
+    progressBar = new QProgressBar;
+    progressBar->setRange(0, 1000);
+    progressBar->setValue(0);
+    progressBar->setTextVisible(false);
+    progressBar->setFixedHeight(8);
+
+    lblStatus = new QLabel("Idle");
+    lblStatus->setObjectName("StatusLabel");
+    lblStatus->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Preferred);
 
     QVBoxLayout* console_output_layout = new QVBoxLayout;
-    console_output_layout->addWidget(console_label);
-    console_output_layout->addWidget(log);
+    console_output_layout->addWidget(progressBar);
+    console_output_layout->addWidget(lblStatus);
+    console_output_layout->addWidget(outputTabs);
 
     // --- main layout ---
     QVBoxLayout *mainLayout = new QVBoxLayout;
@@ -437,24 +492,145 @@ MainWindow::MainWindow(QWidget *parent)
     });
 
 
-    // --- process connections ---
-    connect(&proc, &QProcess::readyReadStandardOutput, this, &MainWindow::readStdout);
-    connect(&proc, &QProcess::readyReadStandardError, this, &MainWindow::readStderr);
-    connect(&proc, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &MainWindow::processFinished);
+    // --- downloads ---
+    downloads = new DownloadManager(this);
+    queue = downloads->queue();
+    ytDlpPath = downloads->ytDlpPath();
+    ffmpegPath = downloads->ffmpegPath();
+    deps = downloads->dependencies();
 
-    // --- deps paths ---
-    depsPath = QDir(qApp->applicationDirPath()).filePath("deps");
-#ifdef Q_OS_WIN
-    ytDlpPath = QDir(depsPath).filePath("yt-dlp.exe");
-    ffmpegPath = QDir(depsPath).filePath("ffmpeg.exe");
-#else
-    ytDlpPath = QDir(depsPath).filePath("yt-dlp");
-    ffmpegPath = QDir(depsPath).filePath("ffmpeg");
-#endif
+    connect(downloads, &DownloadManager::logLine, this, [=](const QString &line) { log->append(line); });
+
+    // --- secondary panels, built the first time their tab is opened ---
+    QWidget* queueTab = new QWidget;
+    QWidget* dashboardTab = new QWidget;
+    outputTabs->addTab(queueTab, "Queue");
+    outputTabs->addTab(dashboardTab, "Dashboard");
+
+    connect(outputTabs, &QTabWidget::currentChanged, this, [=](int index) {
+        QWidget* tab = outputTabs->widget(index);
+        if ((tab != queueTab && tab != dashboardTab) || tab->layout()) { return; }
+
+        QVBoxLayout* tabLayout = new QVBoxLayout(tab);
+        tabLayout->setContentsMargins(0, 0, 0, 0);
+        if (tab == queueTab)
+            tabLayout->addWidget(new QueueView(queue, downloads->postProcessor()));
+        else
+            tabLayout->addWidget(new MetricsDashboard(downloads->metrics()));
+        StartupTrace::mark(outputTabs->tabText(index) + " tab built");
+    });
+
+    connect(downloads, &DownloadManager::batchChanged, this, [=] { progressDirty = true; });
+    connect(downloads->bandwidth(), &BandwidthScheduler::rateChanged, this, [=] { progressDirty = true; });
+    connect(downloads, &DownloadManager::finished, this, &MainWindow::queueIdle);
+
+    connect(queue, &DownloadQueue::jobLines, this, &MainWindow::appendJobLines);
+    connect(queue, &DownloadQueue::jobProgress, this, &MainWindow::jobProgress);
+    connect(queue, &DownloadQueue::jobFinished, this, &MainWindow::jobFinished);
+
+    // --- metadata prefetch ---
+    connect(leUrl, &QLineEdit::editingFinished, this, &MainWindow::prefetchMetadata);
+    connect(downloads->metadata(), &MetadataService::ready, this, &MainWindow::metadataReady);
+
+    connect(sbParallel, QOverload<int>::of(&QSpinBox::valueChanged), this, [=](int n) {
+        queue->setMaxWorkers(n);
+        QSettings().setValue("max_parallel_downloads", n);
+    });
+
+    progressTimer.setInterval(100);
+    connect(&progressTimer, &QTimer::timeout, this, &MainWindow::refreshProgress);
+    progressTimer.start();
+
+    connect(deps, &DependencyManager::ready, this, &MainWindow::dependenciesReady);
+
+    leUrl->installEventFilter(this);
+    StartupTrace::mark("window constructed");
+}
+
+// the URL field is in the first frame whatever covers the window itself
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == leUrl && event->type() == QEvent::Paint)
+    {
+        leUrl->removeEventFilter(this);
+        StartupTrace::mark("first paint");
+
+        // the rest waits until this frame is on screen, and runs before
+        // anything queued by those told about it
+        QTimer::singleShot(0, this, &MainWindow::finishStartup);
+        emit firstPainted();
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+// everything the first frame can do without: font, icons, archive,
+// templates, journal, metrics endpoint and the dependency check
+void MainWindow::finishStartup()
+{
+    applyInterFont();
+    StartupTrace::mark("font loaded");
+
+    applyThemeIcons();
+    StartupTrace::mark("icons decoded");
+
+    downloads->openArchive();
+    StartupTrace::mark("archive loaded");
 
-    if (shouldUpdateYtDlp())
-        QTimer::singleShot(0, this, &MainWindow::updateYtDlpAsync);
+    downloads->loadTemplates();
+    StartupTrace::mark("templates loaded");
+
+    QSettings settings;
+    if (settings.value("job_journal_enabled", true).toBool() && !downloads->openJournal(DownloadManager::defaultJournalPath()))
+        log->append("Job journal not opened (in use by a headless run?), jobs will not be resumed after a crash");
+    StartupTrace::mark("journal opened");
+
+    int metricsPort = settings.value("metrics_port", 0).toInt();
+    if (metricsPort > 0)
+    {
+        MetricsRecorder* metrics = downloads->metrics();
+        metricsServer = new LocalHttpServer(this);
+        metricsServer->addRoute("GET", "/metrics", [metrics](const HttpRequest &) {
+            return HttpResponse{200, "text/plain; version=0.0.4; charset=utf-8", metrics->toPrometheus()};
+        });
+        metricsServer->addRoute("GET", "/metrics.json", [metrics](const HttpRequest &) {
+            return HttpResponse{200, "application/json", metrics->toJson()};
+        });
+        if (metricsServer->listen(metricsPort))
+            log->append(QString("Metrics on http://127.0.0.1:%1/metrics").arg(metricsPort));
+        StartupTrace::mark("metrics server listening");
+    }
+
+    int controlPort = settings.value("control_port", 0).toInt();
+    if (controlPort > 0)
+    {
+        controlServer = new ControlServer(downloads, this);
+        QByteArray token = settings.value("control_token").toByteArray();
+        if (token.isEmpty())
+            token = ControlServer::loadToken(ControlServer::defaultTokenPath());
+        controlServer->setToken(token);
+        controlServer->setDefaults([this](DownloadRequest &req, QString &error) {
+            return prepareRemoteRequest(req, error);
+        });
+        // only once the request was accepted, a rejected one leaves the console alone
+        connect(controlServer, &ControlServer::submitting, this, &MainWindow::startBatch);
+        connect(controlServer, &ControlServer::submitted, this, [=](const DownloadManager::IngestStats &r) {
+            log->append(QString("Control API: queued %1 URL(s), skipped %2")
+                            .arg(r.accepted).arg(r.duplicates + r.archived + r.invalid));
+        });
+        connect(controlServer, &ControlServer::canceled, this, [=](const QList<int> &ids) {
+            log->append(ids.isEmpty() ? QString("Control API: canceled all downloads")
+                                      : QString("Control API: canceled %1 download(s)").arg(ids.size()));
+        });
+        if (token.isEmpty())
+            log->append("Control API disabled: no token could be written to " + ControlServer::defaultTokenPath());
+        else if (controlServer->listen(controlPort))
+            log->append(QString("Control API on http://127.0.0.1:%1/jobs").arg(controlPort));
+        StartupTrace::mark("control server listening");
+    }
+
+    // the update check follows once the tools are known
+    deps->check();
+    StartupTrace::mark("dependency check started");
 }
 
 
@@ -468,67 +644,53 @@ void MainWindow::chooseDir()
 void MainWindow::showHelp()
 {
     QMessageBox::information(this, "Help",
-        "Usage:\n  mode: video or audio\n  URL: must start with http:// or https://\n\nThis GUI is a helper wrapper around yt-dlp and ffmpeg.\nMake sure yt-dlp and ffmpeg are in release/deps.");
+        "Usage:\n  mode: video or audio\n  URL: one or more, separated by spaces, must start with http:// or https://\n  Parallel: how many downloads run at the same time\n  Ctrl+Shift+V or drag and drop: queue every URL in the pasted text or dropped files\n\nThis GUI is a helper wrapper around yt-dlp and ffmpeg.\nMake sure yt-dlp and ffmpeg are in release/deps.");
 }
 
 void MainWindow::cancelDownload()
 {
-    if (!btnIsRunning)
+    if (downloads->isIdle())
     {
-        QMessageBox::information(this, "Cancel", "No download is currently running.");
+        notify("No download is currently running.");
         return;
     }
 
-    log->append("\nCancelling current download...");
+    // returns right away, every job reports back as it stops
+    log->append("\nCancelling all downloads...");
+    downloads->cancelAll();
 
-    proc.terminate();
-
-    if (!proc.waitForFinished(5000))
-    {
-        log->append("Forcing process to stop...");
-        proc.kill();
-        proc.waitForFinished();
-    }
-
-    btnIsRunning = false;
-
-    log->append("Download canceled by user.");
-    QMessageBox::information(this, "Canceled", "Download canceled.\nYou may want to delete incomplete files from the destination folder.");
+    notify("Downloads canceled. Incomplete files are removed as soon as yt-dlp has stopped.");
 }
 
 
 void MainWindow::startDownload()
 {
-    // double execution block
-    if (btnIsRunning)
-    {
-        QMessageBox::information(this, "Busy", "A download is already running.");
-        return;
-    }
-
-    // getting widgets
-    QString cookies = cbCookies ? cbCookies->currentText() : "---";
-    QString mode = cbMode ? cbMode->currentText() : "video";
-    QString format = cbFormat ? cbFormat->currentText() : "mp4";
-
-    QString url = leUrl->text().trimmed();
-    QString dir = lePath->text().trimmed();
+    QStringList urls = leUrl->text().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
     QString custom = leCustom->text().trimmed();
 
     // --- validations ---
-    if (url.isEmpty() || (!url.startsWith("http://") && !url.startsWith("https://")))
+    if (urls.isEmpty())
     {
         QMessageBox::warning(this, "Error", "Invalid URL. Must start with http:// or https://");
         return;
     }
-    if (dir.isEmpty())
+    for (const QString &url : urls)
     {
-        QMessageBox::warning(this, "Error", "Choose a destination directory.");
-        return;
+        if (!isHttpUrl(url))
+        {
+            QMessageBox::warning(this, "Error", "Invalid URL: " + url + "\nMust start with http:// or https://");
+            return;
+        }
+    }
+
+    if (urls.size() > 1 && !custom.isEmpty())
+    {
+        log->append("Warning: multiple URLs — using yt-dlp's auto name.");
+        custom.clear();
+        leCustom->clear();
     }
 
-    bool is_playlist = isPlaylistUrl(url);
-    if (is_playlist)
+    if (!custom.isEmpty() && isPlaylistUrl(urls.first()))
     {
         log->append("Warning: playlist detected — using yt-dlp's auto name.");
         custom.clear();
@@ -545,121 +707,349 @@ void MainWindow::startDownload()
         }
     }
 
-    QDir qd(dir);
-    if (!qd.exists() && !qd.mkpath(dir))
+    DownloadRequest req;
+    if (!prepareRequest(req)) { return; }
+    req.customName = custom;
+
+    // a custom name is for exactly this URL, as typed
+    if (!custom.isEmpty())
     {
-        QMessageBox::critical(this, "Error", "Failed to create the directory: " + dir);
+        startBatch();
+        req.url = urls.first();
+        downloads->submit(req);
         return;
     }
+    queueUrls(req, urls);
+}
 
-    // --- check dependencies ---
-    log->append("Checking dependencies: yt-dlp and ffmpeg...");
-
-    if (!ensureYtDlp()) { return; }
-    if (!ensureFfmpeg()) { return; }
-
-    // --- output path ---
-    QString outputTemplate;
-    if (!custom.isEmpty())
-        outputTemplate = dir + "/" + custom + ".%(ext)s";
-    else if (is_playlist)
-        outputTemplate = dir + "/%(playlist)s/%(playlist_index)03d - %(title)s.%(ext)s";
-    else
-        outputTemplate = dir + "/%(title)s.%(ext)s";
-
-    // --- base arguments ---
-    QStringList args;
-    args << "--ffmpeg-location" << ffmpegPath;
+// the options picked in the widgets, unchecked
+void MainWindow::readOptions(DownloadRequest &req)
+{
+    QString cookies = cbCookies ? cbCookies->currentText() : "---";
+    req.cookiesBrowser = (cookies != "---") ? cookies : QString();
+    req.mode = cbMode ? cbMode->currentText() : "video";
+    req.format = cbFormat ? cbFormat->currentText() : "mp4";
 
-    QString videoQuality = (videoQualityGroup && videoQualityGroup->checkedButton())
+    req.videoQuality = (videoQualityGroup && videoQualityGroup->checkedButton())
         ? videoQualityGroup->checkedButton()->text() : "Best";
 
-    QString audioQuality = (audioQualityGroup && audioQualityGroup->checkedButton())
+    req.audioQuality = (audioQualityGroup && audioQualityGroup->checkedButton())
         ? audioQualityGroup->checkedButton()->text() : "Best";
 
+    req.outputDir = lePath->text().trimmed();
+    req.perf = PerformanceProfile::fromSettings();
+}
+
+// options from the widgets, destination and tools checked
+bool MainWindow::prepareRequest(DownloadRequest &req)
+{
+    readOptions(req);
 
-    // --- adding cookies ---
-    if (cookies != "---")
+    QString dir = req.outputDir;
+    if (dir.isEmpty())
     {
-        args << "--cookies-from-browser" << cookies;
+        QMessageBox::warning(this, "Error", "Choose a destination directory.");
+        return false;
     }
 
-    // --- audio mode ---
-    if (mode == "audio")
+    QDir qd(dir);
+    if (!qd.exists() && !qd.mkpath(dir))
     {
-        args << "-x";
+        QMessageBox::critical(this, "Error", "Failed to create the directory: " + dir);
+        return false;
+    }
 
-        args << "--embed-thumbnail";
+    // --- check dependencies ---
+    if (!ensureYtDlp()) { return false; }
+    if (!ensureFfmpeg()) { return false; }
 
-        args << "--audio-format" << format;
+    return true;
+}
 
-        if (audioQuality != "Best")
-            args << "--audio-quality" << audioQuality;
-    }
-    else // --- video mode ---
+// same for the control API, which gets the reason instead of a dialog
+bool MainWindow::prepareRemoteRequest(DownloadRequest &req, QString &error)
+{
+    readOptions(req);
+
+    if (!deps->ytDlp().usable() || !deps->ffmpeg().usable())
     {
-        QString qualityValue = videoQuality;
-        qualityValue.remove("p"); // ex: "720p" -> "720"
+        error = "yt-dlp or ffmpeg not found or not executable";
+        return false;
+    }
+    return true;
+}
 
-        if (videoQuality == "Best" || videoQuality == "4K")
-            qualityValue = "2160"; // 4K = 2160p
+// URLs from another launch (or this one's command line)
+void MainWindow::openUrls(const QStringList &urls)
+{
+    if (isMinimized())
+        showNormal();
+    raise();
+    activateWindow();
 
-        QString formatArg = QString("bestvideo[height<=%1]+bestaudio/best").arg(qualityValue);
-        args << "-f" << formatArg;
-        args << "--merge-output-format" << format;
-    }
+    if (!urls.isEmpty())
+        ingestText(urls.join('\n'));
+}
 
-    args << url << "-o" << outputTemplate;
+void MainWindow::startBatch()
+{
+    if (!downloads->isIdle()) { return; }
 
-    // --- starting process ---
     log->clear();
-    log->append("Running command: " + ytDlpPath + " " + args.join(" "));
+    downloads->resetBatch();
+    runningPercent.clear();
+}
+
+void MainWindow::queueUrls(const DownloadRequest &req, const QStringList &urls)
+{
+    startBatch();
+
+    QElapsedTimer timer;
+    timer.start();
+    DownloadManager::IngestStats r = downloads->submitUrls(req, urls);
+
+    QStringList skipped;
+    if (r.duplicates > 0)
+        skipped << QString("%1 already queued").arg(r.duplicates);
+    if (r.archived > 0)
+        skipped << QString("%1 already downloaded").arg(r.archived);
+    if (r.invalid > 0)
+        skipped << QString("%1 invalid").arg(r.invalid);
+
+    QString text = QString("Queued %1 URL(s)").arg(r.accepted);
+    if (!skipped.isEmpty())
+        text += ", skipped " + skipped.join(", ");
+    if (urls.size() > 1 || r.accepted == 0)
+        notify(text + QString(" (%1 ms)").arg(timer.elapsed()));
+}
 
-    proc.start(ytDlpPath, args);
-    if (!proc.waitForStarted(5000))
+// pasted or dropped text, files and links, of any size
+void MainWindow::ingestText(const QString &text)
+{
+    QStringList urls = scanUrls(text);
+    if (urls.isEmpty())
     {
-        QMessageBox::critical(this, "Error", "Failed to execute yt-dlp.");
+        notify("No http:// or https:// URLs found.");
         return;
     }
 
-    btnIsRunning = true;
+    DownloadRequest req;
+    if (!prepareRequest(req)) { return; }
+    queueUrls(req, urls);
 }
 
+void MainWindow::ingestMime(const QMimeData *mime)
+{
+    if (!mime) { return; }
+
+    QString text;
+    if (mime->hasUrls())
+    {
+        const QList<QUrl> urls = mime->urls();
+        for (const QUrl &u : urls)
+        {
+            if (!u.isLocalFile())
+            {
+                text += u.toString() + '\n';
+                continue;
+            }
+
+            // URL lists, bookmarks exports, CSVs...
+            QFile f(u.toLocalFile());
+            if (f.size() > maxIngestFileBytes || !f.open(QIODevice::ReadOnly))
+            {
+                log->append("Could not read " + u.toLocalFile());
+                continue;
+            }
+            text += QString::fromUtf8(f.readAll()) + '\n';
+        }
+    }
+    else if (mime->hasText())
+    {
+        text = mime->text();
+    }
+    ingestText(text);
+}
 
+void MainWindow::dragEnterEvent(QDragEnterEvent *event)
+{
+    if (event->mimeData()->hasUrls() || event->mimeData()->hasText())
+        event->acceptProposedAction();
+}
 
-void MainWindow::readStdout()
+void MainWindow::dropEvent(QDropEvent *event)
 {
-    QByteArray b = proc.readAllStandardOutput();
-    if (!b.isEmpty())
+    event->acceptProposedAction();
+    ingestMime(event->mimeData());
+}
+
+
+
+void MainWindow::prefetchMetadata()
+{
+    if (!deps->ytDlp().usable()) { return; }
+
+    QStringList extraArgs;
+    if (cbCookies->currentText() != "---")
+        extraArgs << "--cookies-from-browser" << cbCookies->currentText();
+
+    const QStringList urls = leUrl->text().split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
+    for (const QString &url : urls)
     {
-        log->moveCursor(QTextCursor::End);
-        log->insertPlainText(QString::fromLocal8Bit(b));
-        log->verticalScrollBar()->setValue(log->verticalScrollBar()->maximum());
+        if (!isHttpUrl(url)) { continue; }
+        if (isPlaylistUrl(url)) { continue; }
+
+        downloads->metadata()->fetch(url, extraArgs);
     }
 }
 
-void MainWindow::readStderr()
+void MainWindow::metadataReady(const QString &url, const VideoMetadata &md)
+{
+    // only preview what is still typed in, the cache keeps the rest
+    if (!leUrl->text().contains(url)) { return; }
+
+    QString preview = QString("%1  —  %2, %3 formats")
+        .arg(md.title, formatDuration(static_cast<int>(md.duration)))
+        .arg(md.formats.size());
+
+    log->append("Metadata: " + preview);
+    if (queue->isIdle())
+        lblStatus->setText(preview);
+}
+
+void MainWindow::appendJobLines(int id, const QStringList &lines)
+{
+    QStringList tagged;
+    tagged.reserve(lines.size());
+    for (const QString &line : lines)
+        tagged << QString("[#%1] %2").arg(id).arg(line);
+
+    log->appendLines(tagged);
+}
+
+void MainWindow::jobProgress(int id, const ProgressEvent &ev)
+{
+    double p = ev.percent();
+    if (p >= 0)
+        runningPercent[id] = p;
+
+    lastProgressJob = id;
+    progressDirty = true;
+}
+
+void MainWindow::refreshProgress()
+{
+    if (!progressDirty) { return; }
+    progressDirty = false;
+
+    const DownloadManager::BatchStats &batch = downloads->batch();
+
+    // finished jobs count as 100%, running ones by their own progress
+    double sum = 100.0 * batch.finished();
+    for (double p : runningPercent)
+        sum += p;
+
+    progressBar->setValue(batch.total > 0 ? static_cast<int>(10.0 * sum / batch.total) : 0);
+
+    const DownloadJob* j = queue->job(lastProgressJob);
+    QString row = QString("%1/%2 done, %3 running")
+        .arg(batch.finished())
+        .arg(batch.total)
+        .arg(queue->runningCount());
+
+    PostProcessor* post = downloads->postProcessor();
+    if (!post->isIdle())
+        row += QString(", %1 converting").arg(post->runningCount() + post->pendingCount());
+
+    BandwidthScheduler* rates = downloads->bandwidth();
+    if (rates->isPaused())
+        row += "  (paused by bandwidth schedule)";
+    else if (rates->targetRate() > 0 && queue->runningCount() > 0)
+        row += QString("  at %1/s of %2/s").arg(formatBytes(rates->achievedRate()), formatBytes(rates->targetRate()));
+
+    if (j && j->state == JobState::Running)
+        row += QString("  —  #%1  %2").arg(j->id).arg(j->progress.describe());
+
+    lblStatus->setText(row);
+}
+
+void MainWindow::jobFinished(int id, int exitCode, JobState state)
 {
-    QByteArray b = proc.readAllStandardError();
-    if (!b.isEmpty())
+    runningPercent.remove(id);
+    progressDirty = true;
+
+    switch (state)
     {
-        log->moveCursor(QTextCursor::End);
-        log->insertPlainText(QString::fromLocal8Bit(b));
-        log->verticalScrollBar()->setValue(log->verticalScrollBar()->maximum());
+        case JobState::Finished:
+            log->append(QString("\n[#%1] Command executed successfully.").arg(id));
+            break;
+        case JobState::Canceled:
+            log->append(QString("\n[#%1] canceled.").arg(id));
+            break;
+        default:
+            log->append(QString("\n[#%1] yt-dlp exited with code %2").arg(id).arg(exitCode));
+            break;
     }
 }
 
-void MainWindow::processFinished(int exitCode, QProcess::ExitStatus)
+void MainWindow::dependenciesReady()
 {
-    btnIsRunning = false;
-    if (exitCode == 0)
+    const ToolInfo &y = deps->ytDlp();
+    const ToolInfo &f = deps->ffmpeg();
+
+    log->append(y.usable() ? "yt-dlp " + y.version : "yt-dlp not found: " + y.path);
+    if (f.usable())
     {
-        log->append("\nCommand executed successfully.");
-        QMessageBox::information(this, "Completed", "Download completed successfully.");
+        QString hw = f.hwaccels.isEmpty() ? "none" : f.hwaccels.join(", ");
+        log->append(QString("ffmpeg %1 (%2 encoders, hwaccels: %3)").arg(f.version).arg(f.encoders.size()).arg(hw));
     }
     else
     {
-        log->append(QString("\nyt-dlp exited with code %1").arg(exitCode));
-        QMessageBox::warning(this, "Error", QString("yt-dlp finished with exit code %1").arg(exitCode));
+        log->append("ffmpeg not found: " + f.path);
     }
+
+    // only once per run, later checks come from the update itself
+    if (updateChecked) { return; }
+    updateChecked = true;
+
+    // -U replaces the binary (and cannot at all on Windows while it runs),
+    // so interrupted jobs are resumed once it is through
+    if (shouldUpdateYtDlp() && downloads->isIdle())
+        updateYtDlpAsync([this] { resumeInterrupted(); });
+    else
+        resumeInterrupted();
+}
+
+// whatever was still queued or running when the app last closed
+void MainWindow::resumeInterrupted()
+{
+    if (!deps->ytDlp().usable() || !deps->ffmpeg().usable()) { return; }
+
+    int resumed = downloads->resumeInterrupted();
+    if (resumed > 0)
+        log->append(QString("Resumed %1 interrupted download(s).").arg(resumed));
+}
+
+void MainWindow::queueIdle()
+{
+    const DownloadManager::BatchStats &batch = downloads->batch();
+
+    // cancelDownload() already said so
+    if (batch.canceled > 0 || (batch.done == 0 && batch.failed == 0)) { return; }
+
+    if (batch.failed == 0)
+        notify(QString("%1 download(s) completed successfully.").arg(batch.done));
+    else
+        notify(QString("%1 download(s) completed, %2 failed. See the console output for the reasons.")
+                   .arg(batch.done).arg(batch.failed));
+}
+
+// never blocks: unattended batches must not wait on a click
+void MainWindow::notify(const QString &text)
+{
+    log->append("\n" + text);
+    statusBar()->showMessage(text, notifyTimeoutMs);
+
+    // flashes the taskbar entry while the window is in the background
+    QApplication::alert(this);
 }
@@ -2,13 +2,24 @@
 #define MAIN_WINDOW_HPP
 
 #include "./resources/style_loader.hpp"
+#include "download_manager.hpp"
+#include "console_log.hpp"
+#include "local_http_server.hpp"
+#include "control_server.hpp"
 #include <QMainWindow>
 #include <QRadioButton>
 #include <QComboBox>
 #include <QLineEdit>
-#include <QTextEdit>
+#include <QPlainTextEdit>
 #include <QProcess>
 #include <QPushButton>
+#include <QSpinBox>
+#include <QProgressBar>
+#include <QLabel>
+#include <QTimer>
+#include <QHash>
+
+class QMimeData;
 
 class MainWindow : public QMainWindow
 {
@@ -17,6 +28,17 @@ class MainWindow : public QMainWindow
 public:
     explicit MainWindow(QWidget *parent = nullptr);
 
+    void openUrls(const QStringList &urls);
+
+signals:
+    // the window is on screen and takes input, the deferred stages follow
+    void firstPainted();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void dragEnterEvent(QDragEnterEvent *event) override;
+    void dropEvent(QDropEvent *event) override;
+
 private:
     Theme current_theme = Theme::Dark;
 
@@ -34,34 +56,64 @@ private:
     QLineEdit* leUrl;
     QLineEdit* lePath;
     QLineEdit* leCustom;
-    QTextEdit* log;
+    QPlainTextEdit* logView;
+    ConsoleLog* log;
+    QSpinBox* sbParallel;
+    QProgressBar* progressBar;
+    QLabel* lblStatus;
+
+    DownloadManager* downloads;
+    DownloadQueue* queue;
+    LocalHttpServer* metricsServer = nullptr;
+    ControlServer* controlServer = nullptr;
 
-    QProcess proc;
-    bool btnIsRunning = false;
+    // progress widgets are refreshed on a timer, not per progress line
+    QTimer progressTimer;
+    QHash<int, double> runningPercent;
+    int lastProgressJob = 0;
+    bool progressDirty = false;
 
     // paths
-    QString depsPath;
     QString ytDlpPath;
     QString ffmpegPath;
+    DependencyManager* deps;
+    bool updateChecked = false;
 
     // funcs
     void switchTheme(Theme theme);
     void applyInterFont();
+    void applyThemeIcons();
+    void finishStartup();
     void chooseDir();
     void showHelp();
     void cancelDownload();
     void startDownload();
-    void readStdout();
-    void readStderr();
-    void processFinished(int exitCode, QProcess::ExitStatus status);
-    void updateYtDlpAsync();
+    void readOptions(DownloadRequest &req);
+    bool prepareRequest(DownloadRequest &req);
+    bool prepareRemoteRequest(DownloadRequest &req, QString &error);
+    void startBatch();
+    void queueUrls(const DownloadRequest &req, const QStringList &urls);
+    void ingestText(const QString &text);
+    void ingestMime(const QMimeData *mime);
+    void prefetchMetadata();
+    void metadataReady(const QString &url, const VideoMetadata &md);
+    void appendJobLines(int id, const QStringList &lines);
+    void jobProgress(int id, const ProgressEvent &ev);
+    void refreshProgress();
+    void jobFinished(int id, int exitCode, JobState state);
+    void queueIdle();
+    void notify(const QString &text);
+    void dependenciesReady();
+    void resumeInterrupted();
+    // done runs once yt-dlp -U has exited, or right away when it cannot run
+    void updateYtDlpAsync(std::function<void()> done = {});
 
     bool shouldUpdateYtDlp();
     bool ensureYtDlp();
     bool ensureFfmpeg();
 
-    static void sanitizeFilename(QString &s);
-    static bool isPlaylistUrl(const QString &url);
+    static constexpr int notifyTimeoutMs = 15000;
+    static constexpr qint64 maxIngestFileBytes = 64 * 1024 * 1024;
 };
 
 #endif // MAIN_WINDOW_HPP
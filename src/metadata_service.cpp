@@ -0,0 +1,303 @@
+#include "metadata_service.hpp"
+
+#include <QProcess>
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QCryptographicHash>
+
+
+// ---------- Helper functions ----------
+static bool isMp4Video(const FormatInfo &f)
+{
+    return f.vcodec.startsWith("avc") || f.vcodec.startsWith("h264");
+}
+
+static bool isMp4Audio(const FormatInfo &f)
+{
+    return f.acodec.startsWith("mp4a") || f.ext == "m4a";
+}
+
+
+// ---------- VideoMetadata ----------
+QString VideoMetadata::resolveVideoFormat(int maxHeight, const QString &container) const
+{
+    const bool mp4 = (container == "mp4");
+
+    // highest resolution first, then codecs mp4 can hold without surprises, then bitrate
+    const FormatInfo* video = nullptr;
+    for (const FormatInfo &f : formats)
+    {
+        if (!f.hasVideo() || f.height <= 0 || f.height > maxHeight) { continue; }
+        if (!video) { video = &f; continue; }
+
+        if (f.height != video->height)
+        {
+            if (f.height > video->height) video = &f;
+            continue;
+        }
+        if (mp4 && isMp4Video(f) != isMp4Video(*video))
+        {
+            if (isMp4Video(f)) video = &f;
+            continue;
+        }
+        if (f.tbr > video->tbr) video = &f;
+    }
+    if (!video) { return {}; }
+
+    // progressive format, nothing to merge
+    if (video->hasAudio()) { return video->id; }
+
+    const FormatInfo* audio = nullptr;
+    for (const FormatInfo &f : formats)
+    {
+        if (!f.hasAudio() || f.hasVideo()) { continue; }
+        if (!audio) { audio = &f; continue; }
+
+        if (mp4 && isMp4Audio(f) != isMp4Audio(*audio))
+        {
+            if (isMp4Audio(f)) audio = &f;
+            continue;
+        }
+        if (f.abr > audio->abr) audio = &f;
+    }
+    if (!audio) { return {}; }
+
+    return video->id + "+" + audio->id;
+}
+
+QString VideoMetadata::resolveAudioFormat() const
+{
+    const FormatInfo* audio = nullptr;
+    for (const FormatInfo &f : formats)
+    {
+        if (!f.hasAudio() || f.hasVideo()) { continue; }
+        if (!audio || f.abr > audio->abr) audio = &f;
+    }
+    return audio ? audio->id : QString();
+}
+
+VideoMetadata VideoMetadata::fromYtDlpJson(const QJsonObject &o)
+{
+    VideoMetadata md;
+    md.url = o.value("webpage_url").toString();
+    md.id = o.value("id").toString();
+    md.extractor = o.value("extractor_key").toString();
+    md.title = o.value("title").toString();
+    md.uploader = o.value("uploader").toString();
+    md.duration = o.value("duration").toDouble();
+
+    const QJsonArray formats = o.value("formats").toArray();
+    md.formats.reserve(formats.size());
+    for (const QJsonValue &v : formats)
+    {
+        const QJsonObject f = v.toObject();
+
+        FormatInfo fi;
+        fi.id = f.value("format_id").toString();
+        fi.ext = f.value("ext").toString();
+        fi.vcodec = f.value("vcodec").toString();
+        fi.acodec = f.value("acodec").toString();
+
+        // storyboards and other non media entries
+        if (!fi.hasVideo() && !fi.hasAudio()) { continue; }
+
+        fi.width = f.value("width").toInt();
+        fi.height = f.value("height").toInt();
+        fi.fps = f.value("fps").toDouble();
+        fi.tbr = f.value("tbr").toDouble();
+        fi.abr = f.value("abr").toDouble();
+        fi.filesize = static_cast<qint64>(f.value("filesize").toDouble(-1));
+        if (fi.filesize < 0)
+            fi.filesize = static_cast<qint64>(f.value("filesize_approx").toDouble(-1));
+
+        md.formats.append(fi);
+    }
+
+    md.fetchedAt = QDateTime::currentSecsSinceEpoch();
+    return md;
+}
+
+VideoMetadata VideoMetadata::fromCacheJson(const QJsonObject &o)
+{
+    VideoMetadata md;
+    md.url = o.value("url").toString();
+    md.id = o.value("id").toString();
+    md.extractor = o.value("extractor").toString();
+    md.title = o.value("title").toString();
+    md.uploader = o.value("uploader").toString();
+    md.duration = o.value("duration").toDouble();
+    md.fetchedAt = static_cast<qint64>(o.value("fetched_at").toDouble());
+
+    const QJsonArray formats = o.value("formats").toArray();
+    md.formats.reserve(formats.size());
+    for (const QJsonValue &v : formats)
+    {
+        // [id, ext, vcodec, acodec, width, height, fps, tbr, abr, filesize]
+        const QJsonArray a = v.toArray();
+        if (a.size() < 10) { continue; }
+
+        FormatInfo fi;
+        fi.id = a[0].toString();
+        fi.ext = a[1].toString();
+        fi.vcodec = a[2].toString();
+        fi.acodec = a[3].toString();
+        fi.width = a[4].toInt();
+        fi.height = a[5].toInt();
+        fi.fps = a[6].toDouble();
+        fi.tbr = a[7].toDouble();
+        fi.abr = a[8].toDouble();
+        fi.filesize = static_cast<qint64>(a[9].toDouble(-1));
+        md.formats.append(fi);
+    }
+    return md;
+}
+
+QJsonObject VideoMetadata::toCacheJson() const
+{
+    QJsonArray list;
+    for (const FormatInfo &f : formats)
+    {
+        list.append(QJsonArray{f.id, f.ext, f.vcodec, f.acodec, f.width, f.height,
+                               f.fps, f.tbr, f.abr, static_cast<double>(f.filesize)});
+    }
+
+    return QJsonObject{
+        {"url", url},
+        {"id", id},
+        {"extractor", extractor},
+        {"title", title},
+        {"uploader", uploader},
+        {"duration", duration},
+        {"fetched_at", static_cast<double>(fetchedAt)},
+        {"formats", list},
+    };
+}
+
+
+// ---------- MetadataService ----------
+MetadataService::MetadataService(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void MetadataService::setCacheDir(const QString &dir)
+{
+    cacheDir = dir;
+}
+
+QString MetadataService::cacheFile(const QString &url) const
+{
+    QByteArray key = QCryptographicHash::hash(url.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return QDir(cacheDir).filePath(QString::fromLatin1(key) + ".json");
+}
+
+bool MetadataService::isFresh(const VideoMetadata &md) const
+{
+    return QDateTime::currentSecsSinceEpoch() - md.fetchedAt < ttl;
+}
+
+bool MetadataService::lookup(const QString &url, VideoMetadata &out)
+{
+    auto it = memory.constFind(url);
+    if (it != memory.constEnd() && isFresh(it.value()))
+    {
+        out = it.value();
+        return true;
+    }
+
+    if (cacheDir.isEmpty()) { return false; }
+
+    QFile f(cacheFile(url));
+    if (!f.open(QIODevice::ReadOnly)) { return false; }
+
+    VideoMetadata md = VideoMetadata::fromCacheJson(QJsonDocument::fromJson(f.readAll()).object());
+    if (!md.isValid() || !isFresh(md))
+    {
+        f.remove();
+        return false;
+    }
+
+    memory.insert(url, md);
+    out = md;
+    return true;
+}
+
+void MetadataService::fetch(const QString &url, const QStringList &extraArgs)
+{
+    VideoMetadata md;
+    if (lookup(url, md))
+    {
+        emit ready(url, md);
+        return;
+    }
+
+    if (inFlight.contains(url)) { return; }
+    inFlight.insert(url);
+
+    waiting.append({url, extraArgs});
+    startProbes();
+}
+
+void MetadataService::startProbes()
+{
+    while (running < maxProbes && !waiting.isEmpty())
+    {
+        Probe probe = waiting.takeFirst();
+        running++;
+
+        QProcess* p = new QProcess(this);
+
+        connect(p, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this,
+            [=](int code, QProcess::ExitStatus status) {
+                running--;
+                inFlight.remove(probe.url);
+
+                QJsonDocument doc = QJsonDocument::fromJson(p->readAllStandardOutput());
+                if (status == QProcess::NormalExit && code == 0 && doc.isObject())
+                {
+                    VideoMetadata md = VideoMetadata::fromYtDlpJson(doc.object());
+                    md.url = probe.url;
+                    store(md);
+                    emit ready(probe.url, md);
+                }
+                else
+                {
+                    emit failed(probe.url, QString::fromLocal8Bit(p->readAllStandardError()).trimmed());
+                }
+
+                p->deleteLater();
+                startProbes();
+            });
+
+        connect(p, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+            if (error != QProcess::FailedToStart) { return; }
+
+            running--;
+            inFlight.remove(probe.url);
+            emit failed(probe.url, "could not run yt-dlp");
+
+            p->deleteLater();
+            startProbes();
+        });
+
+        QStringList args = probe.extraArgs;
+        args << "-J" << "--no-playlist" << "--no-warnings" << probe.url;
+        p->start(ytDlpPath, args);
+    }
+}
+
+void MetadataService::store(const VideoMetadata &md)
+{
+    memory.insert(md.url, md);
+
+    if (cacheDir.isEmpty()) { return; }
+
+    QDir().mkpath(cacheDir);
+    QFile f(cacheFile(md.url));
+    if (f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        f.write(QJsonDocument(md.toCacheJson()).toJson(QJsonDocument::Compact));
+}
@@ -0,0 +1,98 @@
+#ifndef METADATA_SERVICE_HPP
+#define METADATA_SERVICE_HPP
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QJsonObject>
+
+
+struct FormatInfo
+{
+    QString id;
+    QString ext;
+    QString vcodec;
+    QString acodec;
+    int width = 0;
+    int height = 0;
+    double fps = 0;
+    double tbr = 0;          // total bitrate, KBit/s
+    double abr = 0;          // audio bitrate, KBit/s
+    qint64 filesize = -1;    // exact or approximate, -1 when unknown
+
+    bool hasVideo() const { return !vcodec.isEmpty() && vcodec != "none"; }
+    bool hasAudio() const { return !acodec.isEmpty() && acodec != "none"; }
+};
+
+struct VideoMetadata
+{
+    QString url;
+    QString id;
+    QString extractor;       // extractor key, e.g. "Youtube"
+    QString title;
+    QString uploader;
+    double duration = 0;     // seconds
+    QVector<FormatInfo> formats;
+    qint64 fetchedAt = 0;    // secs since epoch
+
+    bool isValid() const { return !id.isEmpty(); }
+
+    // exact "-f" values, empty when no listed format fits
+    QString resolveVideoFormat(int maxHeight, const QString &container) const;
+    QString resolveAudioFormat() const;
+
+    static VideoMetadata fromYtDlpJson(const QJsonObject &o);
+    static VideoMetadata fromCacheJson(const QJsonObject &o);
+    QJsonObject toCacheJson() const;
+};
+
+// Runs "yt-dlp -J" once per URL and keeps the result in memory and in a
+// small on-disk cache, so later lookups cost no process launch.
+class MetadataService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MetadataService(QObject *parent = nullptr);
+
+    void setProgram(const QString &program) { ytDlpPath = program; }
+    // created with the first entry written there
+    void setCacheDir(const QString &dir);
+    void setTtl(qint64 seconds) { ttl = seconds; }
+    void setMaxProbes(int n) { maxProbes = qMax(1, n); }
+
+    // memory or disk cache only, never spawns yt-dlp
+    bool lookup(const QString &url, VideoMetadata &out);
+
+    // emits ready() right away on a cache hit, probes otherwise
+    void fetch(const QString &url, const QStringList &extraArgs = {});
+
+signals:
+    void ready(const QString &url, const VideoMetadata &md);
+    void failed(const QString &url, const QString &error);
+
+private:
+    QString ytDlpPath;
+    QString cacheDir;
+    qint64 ttl = 6 * 60 * 60;
+    int maxProbes = 2;
+
+    QHash<QString, VideoMetadata> memory;
+
+    struct Probe { QString url; QStringList extraArgs; };
+    QList<Probe> waiting;
+    QSet<QString> inFlight;
+    int running = 0;
+
+    QString cacheFile(const QString &url) const;
+    bool isFresh(const VideoMetadata &md) const;
+    void startProbes();
+    void store(const VideoMetadata &md);
+};
+
+
+#endif // METADATA_SERVICE_HPP
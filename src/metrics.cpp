@@ -0,0 +1,339 @@
+#include "metrics.hpp"
+
+#include <QDateTime>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <utility>
+
+
+// ---------- Helper functions ----------
+static qint64 now()
+{
+    return QDateTime::currentMSecsSinceEpoch();
+}
+
+static QString csvField(QString s)
+{
+    if (s.contains(',') || s.contains('"') || s.contains('\n'))
+        return '"' + s.replace('"', "\"\"") + '"';
+    return s;
+}
+
+static double average(const QList<double> &values)
+{
+    double sum = 0;
+    int n = 0;
+    for (double v : values)
+    {
+        if (v < 0) { continue; }
+        sum += v;
+        n++;
+    }
+    return n ? sum / n : -1;
+}
+
+
+// ---------- JobMetrics ----------
+double JobMetrics::averageSpeed() const
+{
+    double t = downloadTime();
+    return t > 0 ? bytes / t : 0;
+}
+
+
+// ---------- MetricsRecorder ----------
+MetricsRecorder::MetricsRecorder(DownloadQueue *queue, PostProcessor *post, QObject *parent)
+    : QObject(parent), queue(queue), post(post)
+{
+    connect(queue, &DownloadQueue::jobQueued, this, &MetricsRecorder::jobQueued);
+    connect(queue, &DownloadQueue::jobStarted, this, &MetricsRecorder::jobStarted);
+    connect(queue, &DownloadQueue::jobProgress, this, &MetricsRecorder::jobProgress);
+    connect(queue, &DownloadQueue::jobLines, this, &MetricsRecorder::jobLines);
+    connect(queue, &DownloadQueue::jobFinished, this, &MetricsRecorder::jobFinished);
+
+    connect(post, &PostProcessor::taskStarted, this, [this](int id) {
+        auto it = records.find(id);
+        if (it == records.end()) { return; }
+        it->postStartedAt = now();
+        it->state = "converting";
+    });
+    connect(post, &PostProcessor::taskFinished, this,
+        [this](int id, bool ok, const QString &, const PostProcessReport &report) {
+            auto it = records.find(id);
+            if (it == records.end()) { return; }
+            it->postFinishedAt = now();
+            it->postCpuSeconds = report.cpuSeconds;
+            it->state = ok ? "finished" : "failed";
+        });
+
+    tick.setInterval(1000);
+    connect(&tick, &QTimer::timeout, this, &MetricsRecorder::sample);
+    tick.start();
+}
+
+void MetricsRecorder::jobQueued(int id)
+{
+    auto it = records.find(id);
+    if (it != records.end())
+    {
+        // back in the queue after a start: a restart by the scheduler
+        if (it->startedAt)
+            it->retries++;
+        it->state = "queued";
+        return;
+    }
+
+    JobMetrics m;
+    m.id = id;
+    m.enqueuedAt = now();
+    if (const DownloadJob* j = queue->job(id))
+        m.url = j->url;
+    records.insert(id, m);
+    order << id;
+
+    // finished jobs beyond the cap are forgotten, oldest first
+    for (int i = 0; order.size() > maxRecords && i < order.size(); )
+    {
+        const JobMetrics &old = records[order[i]];
+        if (old.state == "queued" || old.state == "running" || old.state == "converting") { i++; continue; }
+        forgottenBytes += old.bytes;
+        forgottenRetries += old.retries;
+        forgottenQueueWait.add(old.queueWait());
+        forgottenFirstByte.add(old.timeToFirstByte());
+        forgottenDownload.add(old.downloadTime());
+        forgottenPost.add(old.postTime());
+        records.remove(order.takeAt(i));
+    }
+}
+
+void MetricsRecorder::jobStarted(int id)
+{
+    auto it = records.find(id);
+    if (it == records.end()) { return; }
+
+    if (!it->startedAt)
+        it->startedAt = now();
+    it->state = "running";
+}
+
+void MetricsRecorder::jobProgress(int id, const ProgressEvent &ev)
+{
+    auto it = records.find(id);
+    if (it == records.end()) { return; }
+    if (ev.kind != ProgressEvent::Kind::Download) { return; }
+
+    if (!it->firstByteAt && ev.downloadedBytes > 0)
+        it->firstByteAt = now();
+
+    it->speed = qMax(0.0, ev.speed);
+    it->peakSpeed = qMax(it->peakSpeed, it->speed);
+    if (const DownloadJob* j = queue->job(id))
+        it->bytes = j->receivedBytes;
+}
+
+void MetricsRecorder::jobLines(int id, const QStringList &lines)
+{
+    auto it = records.find(id);
+    if (it == records.end()) { return; }
+
+    // "[download] Got error: ... Retrying (1/10)...", "Retrying fragment 3 (2/10)..."
+    for (const QString &line : lines)
+        if (line.contains("Retrying"))
+            it->retries++;
+}
+
+void MetricsRecorder::jobFinished(int id, int exitCode, JobState state)
+{
+    auto it = records.find(id);
+    if (it == records.end()) { return; }
+
+    it->finishedAt = now();
+    it->exitCode = exitCode;
+    it->speed = 0;
+    it->state = jobStateName(state);
+    if (const DownloadJob* j = queue->job(id))
+        it->bytes = j->receivedBytes;
+
+    // audio jobs keep going in the ffmpeg pool
+    if (state == JobState::Finished && post->isQueued(id))
+        it->state = "converting";
+}
+
+void MetricsRecorder::sample()
+{
+    MetricsSample s;
+    s.at = now();
+    s.running = queue->runningCount();
+    s.pending = queue->pendingCount();
+    s.converting = post->runningCount() + post->pendingCount();
+
+    s.bytesTotal = forgottenBytes;
+    for (const JobMetrics &m : std::as_const(records))
+        s.bytesTotal += m.bytes;
+
+    qint64 dt = last.at ? s.at - last.at : 0;
+    if (dt > 0)
+        s.bytesPerSec = qMax<qint64>(0, (s.bytesTotal - last.bytesTotal) * 1000 / dt);
+
+    // an idle queue needs no more flat samples than the one that shows it
+    if (s.running == 0 && s.converting == 0 && last.running == 0 && last.converting == 0 && ring.size() > 0)
+    {
+        last = s;
+        return;
+    }
+
+    last = s;
+    ring.push(s);
+    emit sampled(s);
+}
+
+
+// ---------- aggregates ----------
+QList<JobMetrics> MetricsRecorder::jobs() const
+{
+    QList<JobMetrics> out;
+    out.reserve(order.size());
+    for (int id : order)
+        out << records.value(id);
+    return out;
+}
+
+double MetricsRecorder::averageQueueWait() const
+{
+    QList<double> v;
+    for (const JobMetrics &m : records) v << m.queueWait();
+    return average(v);
+}
+
+double MetricsRecorder::averageTimeToFirstByte() const
+{
+    QList<double> v;
+    for (const JobMetrics &m : records) v << m.timeToFirstByte();
+    return average(v);
+}
+
+double MetricsRecorder::averagePostTime() const
+{
+    QList<double> v;
+    for (const JobMetrics &m : records) v << m.postTime();
+    return average(v);
+}
+
+int MetricsRecorder::totalRetries() const
+{
+    int n = forgottenRetries;
+    for (const JobMetrics &m : records) n += m.retries;
+    return n;
+}
+
+int MetricsRecorder::countInState(const QString &state) const
+{
+    int n = 0;
+    for (const JobMetrics &m : records)
+        if (m.state == state) n++;
+    return n;
+}
+
+
+// ---------- exports ----------
+QByteArray MetricsRecorder::toCsv() const
+{
+    QByteArray out = "id,url,state,exit_code,bytes,queue_wait_s,ttfb_s,download_s,avg_speed,peak_speed,retries,post_s,post_cpu_s\n";
+    for (const JobMetrics &m : jobs())
+    {
+        out += QString("%1,%2,%3,%4,%5,%6,%7,%8,%9,%10,%11,%12,%13\n")
+            .arg(m.id)
+            .arg(csvField(m.url), m.state)
+            .arg(m.exitCode)
+            .arg(m.bytes)
+            .arg(m.queueWait(), 0, 'f', 3)
+            .arg(m.timeToFirstByte(), 0, 'f', 3)
+            .arg(m.downloadTime(), 0, 'f', 3)
+            .arg(qint64(m.averageSpeed()))
+            .arg(qint64(m.peakSpeed))
+            .arg(m.retries)
+            .arg(m.postTime(), 0, 'f', 3)
+            .arg(m.postCpuSeconds, 0, 'f', 3)
+            .toUtf8();
+    }
+    return out;
+}
+
+QByteArray MetricsRecorder::toJson() const
+{
+    QJsonArray jobArray;
+    for (const JobMetrics &m : jobs())
+    {
+        jobArray << QJsonObject{
+            {"id", m.id},
+            {"url", m.url},
+            {"state", m.state},
+            {"exit_code", m.exitCode},
+            {"bytes", m.bytes},
+            {"queue_wait_s", m.queueWait()},
+            {"ttfb_s", m.timeToFirstByte()},
+            {"download_s", m.downloadTime()},
+            {"avg_speed", m.averageSpeed()},
+            {"peak_speed", m.peakSpeed},
+            {"retries", m.retries},
+            {"post_s", m.postTime()},
+            {"post_cpu_s", m.postCpuSeconds},
+        };
+    }
+
+    QJsonArray sampleArray;
+    const QVector<MetricsSample> history = ring.snapshot();
+    for (const MetricsSample &s : history)
+    {
+        sampleArray << QJsonObject{
+            {"at", s.at},
+            {"bytes_per_sec", s.bytesPerSec},
+            {"bytes_total", s.bytesTotal},
+            {"running", s.running},
+            {"pending", s.pending},
+            {"converting", s.converting},
+        };
+    }
+
+    return QJsonDocument(QJsonObject{{"jobs", jobArray}, {"samples", sampleArray}}).toJson(QJsonDocument::Compact);
+}
+
+QByteArray MetricsRecorder::toPrometheus() const
+{
+    QByteArray out;
+    auto metric = [&out](const char *name, const char *type, const char *help) {
+        out += QByteArray("# HELP ") + name + " " + help + "\n# TYPE " + name + " " + type + "\n";
+    };
+
+    metric("ytdlp_gui_jobs", "gauge", "Jobs by state.");
+    for (const char *state : {"queued", "running", "converting", "finished", "failed", "canceled"})
+        out += QString("ytdlp_gui_jobs{state=\"%1\"} %2\n").arg(state).arg(countInState(state)).toUtf8();
+
+    metric("ytdlp_gui_bytes_total", "counter", "Bytes downloaded by all jobs.");
+    out += "ytdlp_gui_bytes_total " + QByteArray::number(last.bytesTotal) + "\n";
+
+    metric("ytdlp_gui_download_speed_bytes", "gauge", "Download rate over the last second.");
+    out += "ytdlp_gui_download_speed_bytes " + QByteArray::number(last.bytesPerSec) + "\n";
+
+    metric("ytdlp_gui_retries_total", "counter", "yt-dlp retries and scheduler restarts.");
+    out += "ytdlp_gui_retries_total " + QByteArray::number(totalRetries()) + "\n";
+
+    // sum/count pairs, so rates can be derived on the Prometheus side
+    auto summary = [&](const char *name, const char *help, double (JobMetrics::*value)() const, Summary total) {
+        metric(name, "summary", help);
+        for (const JobMetrics &m : records)
+            total.add((m.*value)());
+        out += QString("%1_sum %2\n%1_count %3\n").arg(name).arg(total.sum, 0, 'f', 3).arg(total.count).toUtf8();
+    };
+    summary("ytdlp_gui_queue_wait_seconds", "Time from enqueue to start.",
+            &JobMetrics::queueWait, forgottenQueueWait);
+    summary("ytdlp_gui_time_to_first_byte_seconds", "Time from start to the first downloaded byte.",
+            &JobMetrics::timeToFirstByte, forgottenFirstByte);
+    summary("ytdlp_gui_download_seconds", "Time from start to yt-dlp exiting.",
+            &JobMetrics::downloadTime, forgottenDownload);
+    summary("ytdlp_gui_postprocess_seconds", "Time spent in the ffmpeg pool.",
+            &JobMetrics::postTime, forgottenPost);
+
+    return out;
+}
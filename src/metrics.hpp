@@ -0,0 +1,154 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "download_queue.hpp"
+#include "post_processor.hpp"
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QTimer>
+#include <QByteArray>
+#include <array>
+#include <atomic>
+
+
+// Fixed-size ring with a single writer. The writer never waits: it fills
+// the next slot and then publishes it by bumping head, so readers on any
+// thread get a consistent view of every sample but the one being replaced.
+template <typename T, int N>
+class SampleRing
+{
+public:
+    void push(const T &value)
+    {
+        quint64 h = head.load(std::memory_order_relaxed);
+        buffer[h % N] = value;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    // oldest first, at most max samples
+    QVector<T> snapshot(int max = N) const
+    {
+        quint64 h = head.load(std::memory_order_acquire);
+        int n = static_cast<int>(qMin<quint64>(h, static_cast<quint64>(qMin(max, N))));
+
+        QVector<T> out;
+        out.reserve(n);
+        for (quint64 i = h - n; i < h; i++)
+            out << buffer[i % N];
+        return out;
+    }
+
+    int size() const { return static_cast<int>(qMin<quint64>(head.load(std::memory_order_acquire), N)); }
+
+private:
+    std::array<T, N> buffer{};
+    std::atomic<quint64> head{0};
+};
+
+// one aggregate sample per second
+struct MetricsSample
+{
+    qint64 at = 0;           // ms since epoch
+    qint64 bytesPerSec = 0;
+    qint64 bytesTotal = 0;
+    int running = 0;
+    int pending = 0;
+    int converting = 0;
+};
+
+// everything known about one job, times in ms since epoch (0 = not yet)
+struct JobMetrics
+{
+    int id = 0;
+    QString url;
+    qint64 enqueuedAt = 0;
+    qint64 startedAt = 0;
+    qint64 firstByteAt = 0;
+    qint64 finishedAt = 0;
+    qint64 postStartedAt = 0;
+    qint64 postFinishedAt = 0;
+    double postCpuSeconds = -1;
+
+    qint64 bytes = 0;
+    double speed = 0;        // latest, bytes/s
+    double peakSpeed = 0;
+    int retries = 0;         // yt-dlp "Retrying" lines plus scheduler restarts
+    int exitCode = -1;
+    QString state = "queued";
+
+    double queueWait() const { return startedAt ? (startedAt - enqueuedAt) / 1000.0 : -1; }
+    double timeToFirstByte() const { return firstByteAt ? (firstByteAt - startedAt) / 1000.0 : -1; }
+    double downloadTime() const { return finishedAt ? (finishedAt - startedAt) / 1000.0 : -1; }
+    double averageSpeed() const;
+    double postTime() const { return postFinishedAt ? (postFinishedAt - postStartedAt) / 1000.0 : -1; }
+};
+
+// Collects per-job and aggregate numbers from the queue and the ffmpeg
+// pool. Nothing here touches the disk; the exports are built on demand.
+class MetricsRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    MetricsRecorder(DownloadQueue *queue, PostProcessor *post, QObject *parent = nullptr);
+
+    QList<JobMetrics> jobs() const;
+    const SampleRing<MetricsSample, 3600>& samples() const { return ring; }
+    MetricsSample latest() const { return last; }
+
+    // averages over the jobs that got that far, -1 when none did
+    double averageQueueWait() const;
+    double averageTimeToFirstByte() const;
+    double averagePostTime() const;
+    // since startup, including jobs no longer in jobs()
+    int totalRetries() const;
+    int countInState(const QString &state) const;
+
+    QByteArray toCsv() const;
+    QByteArray toJson() const;
+    QByteArray toPrometheus() const;
+
+signals:
+    void sampled(const MetricsSample &sample);
+
+private:
+    DownloadQueue* queue;
+    PostProcessor* post;
+
+    QHash<int, JobMetrics> records;
+    QList<int> order;
+
+    // what trimmed records contributed, so the exported counters never go down
+    struct Summary
+    {
+        double sum = 0;
+        int count = 0;
+
+        void add(double v) { if (v >= 0) { sum += v; count++; } }
+    };
+    qint64 forgottenBytes = 0;
+    int forgottenRetries = 0;
+    Summary forgottenQueueWait;
+    Summary forgottenFirstByte;
+    Summary forgottenDownload;
+    Summary forgottenPost;
+
+    SampleRing<MetricsSample, 3600> ring;
+    MetricsSample last;
+    QTimer tick;
+
+    void jobQueued(int id);
+    void jobStarted(int id);
+    void jobProgress(int id, const ProgressEvent &ev);
+    void jobLines(int id, const QStringList &lines);
+    void jobFinished(int id, int exitCode, JobState state);
+    void sample();
+
+    static constexpr int maxRecords = 5000;
+};
+
+
+#endif // METRICS_HPP
@@ -0,0 +1,166 @@
+#include "metrics_dashboard.hpp"
+#include "progress_parser.hpp"
+
+#include <QLabel>
+#include <QPushButton>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QGridLayout>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QSaveFile>
+#include <QPainter>
+#include <QPainterPath>
+
+
+// ---------- Helper functions ----------
+static QString seconds(double s)
+{
+    return s < 0 ? QString("-") : QString("%1 s").arg(s, 0, 'f', s < 10 ? 2 : 1);
+}
+
+
+// ---------- Sparkline ----------
+Sparkline::Sparkline(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumHeight(60);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+void Sparkline::setSamples(const QVector<MetricsSample> &s)
+{
+    samples = s;
+    update();
+}
+
+void Sparkline::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+
+    QRectF area = rect().adjusted(1, 4, -1, -1);
+    QColor line = palette().color(QPalette::Highlight);
+
+    p.setPen(QPen(palette().color(QPalette::Mid), 1));
+    p.drawLine(area.bottomLeft(), area.bottomRight());
+
+    if (samples.size() < 2) { return; }
+
+    qint64 peak = 1;
+    for (const MetricsSample &s : samples)
+        peak = qMax(peak, s.bytesPerSec);
+
+    // x is sample position, not time: idle gaps are not stored
+    double step = area.width() / (samples.size() - 1);
+    QPainterPath path;
+    for (int i = 0; i < samples.size(); i++)
+    {
+        QPointF pt(area.left() + i * step, area.bottom() - area.height() * samples[i].bytesPerSec / peak);
+        if (i == 0)
+            path.moveTo(pt);
+        else
+            path.lineTo(pt);
+    }
+
+    QPainterPath fill = path;
+    fill.lineTo(area.right(), area.bottom());
+    fill.lineTo(area.left(), area.bottom());
+    fill.closeSubpath();
+
+    QColor shade = line;
+    shade.setAlpha(50);
+    p.fillPath(fill, shade);
+    p.setPen(QPen(line, 1.5));
+    p.drawPath(path);
+
+    p.setPen(palette().color(QPalette::Text));
+    p.drawText(area.adjusted(4, 0, -4, 0), Qt::AlignTop | Qt::AlignRight, formatBytes(peak) + "/s");
+}
+
+
+// ---------- MetricsDashboard ----------
+MetricsDashboard::MetricsDashboard(MetricsRecorder *metrics, QWidget *parent)
+    : QWidget(parent), metrics(metrics)
+{
+    sparkline = new Sparkline;
+
+    lblRate = new QLabel;
+    lblJobs = new QLabel;
+    lblQueueWait = new QLabel;
+    lblFirstByte = new QLabel;
+    lblPost = new QLabel;
+    lblRetries = new QLabel;
+
+    QGridLayout* stats = new QGridLayout;
+    stats->addWidget(new QLabel("Throughput"), 0, 0);
+    stats->addWidget(lblRate, 0, 1);
+    stats->addWidget(new QLabel("Jobs"), 0, 2);
+    stats->addWidget(lblJobs, 0, 3);
+    stats->addWidget(new QLabel("Avg. queue wait"), 1, 0);
+    stats->addWidget(lblQueueWait, 1, 1);
+    stats->addWidget(new QLabel("Avg. time to first byte"), 1, 2);
+    stats->addWidget(lblFirstByte, 1, 3);
+    stats->addWidget(new QLabel("Avg. conversion"), 2, 0);
+    stats->addWidget(lblPost, 2, 1);
+    stats->addWidget(new QLabel("Retries"), 2, 2);
+    stats->addWidget(lblRetries, 2, 3);
+    stats->setColumnStretch(1, 1);
+    stats->setColumnStretch(3, 1);
+
+    QPushButton* btnCsv = new QPushButton("Export CSV");
+    QPushButton* btnJson = new QPushButton("Export JSON");
+    btnCsv->setObjectName("ChooseButton");
+    btnJson->setObjectName("ChooseButton");
+
+    connect(btnCsv, &QPushButton::clicked, this, [this] { exportTo("CSV (*.csv)", this->metrics->toCsv()); });
+    connect(btnJson, &QPushButton::clicked, this, [this] { exportTo("JSON (*.json)", this->metrics->toJson()); });
+
+    QHBoxLayout* buttons = new QHBoxLayout;
+    buttons->addStretch();
+    buttons->addWidget(btnCsv);
+    buttons->addWidget(btnJson);
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addWidget(sparkline);
+    layout->addLayout(stats);
+    layout->addStretch();
+    layout->addLayout(buttons);
+    setLayout(layout);
+
+    // hidden tabs cost nothing but the sample itself
+    connect(metrics, &MetricsRecorder::sampled, this, [this] {
+        if (isVisible())
+            refresh();
+    });
+}
+
+void MetricsDashboard::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+}
+
+void MetricsDashboard::refresh()
+{
+    MetricsSample s = metrics->latest();
+    sparkline->setSamples(metrics->samples().snapshot(windowSamples));
+
+    lblRate->setText(QString("%1/s, %2 total").arg(formatBytes(s.bytesPerSec), formatBytes(s.bytesTotal)));
+    lblJobs->setText(QString("%1 running, %2 queued, %3 converting")
+                         .arg(s.running).arg(s.pending).arg(s.converting));
+    lblQueueWait->setText(seconds(metrics->averageQueueWait()));
+    lblFirstByte->setText(seconds(metrics->averageTimeToFirstByte()));
+    lblPost->setText(seconds(metrics->averagePostTime()));
+    lblRetries->setText(QString::number(metrics->totalRetries()));
+}
+
+void MetricsDashboard::exportTo(const QString &filter, const QByteArray &data)
+{
+    QString path = QFileDialog::getSaveFileName(this, "Export metrics", QString(), filter);
+    if (path.isEmpty()) { return; }
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly) || f.write(data) != data.size() || !f.commit())
+        QMessageBox::critical(this, "Error", "Could not write " + path);
+}
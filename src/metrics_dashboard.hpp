@@ -0,0 +1,58 @@
+#ifndef METRICS_DASHBOARD_HPP
+#define METRICS_DASHBOARD_HPP
+
+#include "metrics.hpp"
+#include <QWidget>
+#include <QVector>
+
+class QLabel;
+
+
+// Throughput sparkline over the last two minutes of samples, plus the
+// job averages. Repaints only when a new sample arrives and it is shown.
+class Sparkline : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit Sparkline(QWidget *parent = nullptr);
+
+    void setSamples(const QVector<MetricsSample> &samples);
+    QSize sizeHint() const override { return QSize(400, 90); }
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QVector<MetricsSample> samples;
+};
+
+class MetricsDashboard : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MetricsDashboard(MetricsRecorder *metrics, QWidget *parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private:
+    MetricsRecorder* metrics;
+    Sparkline* sparkline;
+
+    QLabel* lblRate;
+    QLabel* lblJobs;
+    QLabel* lblQueueWait;
+    QLabel* lblFirstByte;
+    QLabel* lblPost;
+    QLabel* lblRetries;
+
+    void refresh();
+    void exportTo(const QString &filter, const QByteArray &data);
+
+    static constexpr int windowSamples = 120;
+};
+
+
+#endif // METRICS_DASHBOARD_HPP
@@ -0,0 +1,294 @@
+#include "output_template.hpp"
+#include "host_scheduler.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDate>
+#include <QStorageInfo>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+
+// ---------- Helper functions ----------
+namespace
+{
+    struct Token
+    {
+        bool field = false;
+        QString text;        // literal text, or the field name
+    };
+}
+
+static const QStringList knownFields = {"title", "uploader", "id", "extractor", "site", "mode", "date"};
+
+// "{title} [{id}]" -> field title, text " [", field id, text "]"
+static bool tokenize(const QString &component, QList<Token> &tokens)
+{
+    int i = 0;
+    while (i < component.size())
+    {
+        int open = component.indexOf('{', i);
+        if (open < 0)
+        {
+            tokens << Token{false, component.mid(i)};
+            break;
+        }
+        if (open > i)
+            tokens << Token{false, component.mid(i, open - i)};
+
+        int close = component.indexOf('}', open);
+        if (close < 0) { return false; }
+
+        QString name = component.mid(open + 1, close - open - 1);
+        if (!knownFields.contains(name)) { return false; }
+        tokens << Token{true, name};
+        i = close + 1;
+    }
+    return true;
+}
+
+// fields that don't depend on the video
+static QString requestField(const QString &name, const DownloadRequest &req)
+{
+    if (name == "site") { return HostScheduler::siteOf(req.url); }
+    if (name == "mode") { return req.mode; }
+    if (name == "date") { return QDate::currentDate().toString(Qt::ISODate); }
+    return {};
+}
+
+static QString metadataField(const QString &name, const VideoMetadata &md, const DownloadRequest &req)
+{
+    QString value;
+    if (name == "title") value = md.title;
+    else if (name == "uploader") value = md.uploader;
+    else if (name == "id") value = md.id;
+    else if (name == "extractor") value = md.extractor;
+    else value = requestField(name, req);
+
+    // what yt-dlp writes for a missing field
+    return value.isEmpty() ? "NA" : value;
+}
+
+static QString ytDlpField(const QString &name, const DownloadRequest &req)
+{
+    if (name == "title") { return "%(title)s"; }
+    if (name == "uploader") { return "%(uploader)s"; }
+    if (name == "id") { return "%(id)s"; }
+    if (name == "extractor") { return "%(extractor_key)s"; }
+
+    QString value = requestField(name, req);
+    sanitizeFilename(value);
+    return value.replace('%', "%%");
+}
+
+
+// ---------- OutputTemplates ----------
+QString OutputTemplates::defaultPath()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("templates.json");
+}
+
+bool OutputTemplates::load(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) { return false; }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject())
+    {
+        qWarning() << "Ignoring malformed output templates" << path << error.errorString();
+        return false;
+    }
+
+    const QJsonObject templates = doc.object().value("templates").toObject();
+    for (auto it = templates.constBegin(); it != templates.constEnd(); ++it)
+    {
+        QString pattern = it.value().toString();
+        if (!isValid(pattern))
+        {
+            qWarning() << "Ignoring output template" << it.key() << "with unknown fields:" << pattern;
+            continue;
+        }
+        addTemplate(it.key(), pattern);
+    }
+
+    const QJsonArray list = doc.object().value("rules").toArray();
+    for (const QJsonValue &v : list)
+    {
+        QJsonObject o = v.toObject();
+        OutputRule rule{o.value("site").toString().toLower(), o.value("mode").toString(), o.value("template").toString()};
+        if (!named.contains(rule.pattern) && !isValid(rule.pattern))
+        {
+            qWarning() << "Ignoring output rule with unknown template:" << rule.pattern;
+            continue;
+        }
+        addRule(rule);
+    }
+
+    if (doc.object().contains("default"))
+        setDefaultPattern(doc.object().value("default").toString());
+    return true;
+}
+
+void OutputTemplates::setDefaultPattern(const QString &pattern)
+{
+    QString p = named.value(pattern, pattern);
+    if (!isValid(p))
+    {
+        qWarning() << "Ignoring default output template with unknown fields:" << pattern;
+        return;
+    }
+    fallback = p;
+}
+
+QString OutputTemplates::patternFor(const QString &url, const QString &mode) const
+{
+    QString site;
+    for (const OutputRule &rule : rules)
+    {
+        if (!rule.mode.isEmpty() && rule.mode != mode) { continue; }
+        if (!rule.site.isEmpty())
+        {
+            // only worked out once a rule asks for it
+            if (site.isEmpty())
+                site = HostScheduler::siteOf(url);
+            if (rule.site != site) { continue; }
+        }
+        return named.value(rule.pattern, rule.pattern);
+    }
+    return fallback;
+}
+
+bool OutputTemplates::isValid(const QString &pattern)
+{
+    if (pattern.trimmed().isEmpty()) { return false; }
+
+    QList<Token> tokens;
+    return tokenize(pattern, tokens);
+}
+
+QStringList OutputTemplates::expand(const QString &pattern, const VideoMetadata &md, const DownloadRequest &req)
+{
+    QStringList parts;
+    const QStringList components = pattern.split('/', Qt::SkipEmptyParts);
+    for (const QString &component : components)
+    {
+        QList<Token> tokens;
+        if (!tokenize(component, tokens))
+            tokens = {Token{false, component}};
+
+        QString name;
+        for (const Token &t : std::as_const(tokens))
+            name += t.field ? metadataField(t.text, md, req) : t.text;
+
+        sanitizeFilename(name);
+        if (!name.isEmpty())
+            parts << name;
+    }
+
+    if (parts.isEmpty())
+        parts << (md.id.isEmpty() ? QString("download") : md.id);
+    return parts;
+}
+
+QString OutputTemplates::toYtDlp(const QString &pattern, const DownloadRequest &req)
+{
+    QStringList parts;
+    const QStringList components = pattern.split('/', Qt::SkipEmptyParts);
+    for (const QString &component : components)
+    {
+        QList<Token> tokens;
+        if (!tokenize(component, tokens))
+            tokens = {Token{false, component}};
+
+        QString text;
+        for (const Token &t : std::as_const(tokens))
+            text += t.field ? ytDlpField(t.text, req) : QString(t.text).replace('%', "%%");
+        parts << text;
+    }
+    return parts.isEmpty() ? QString("%(title)s") : parts.join('/');
+}
+
+
+// ---------- NameIndex ----------
+QString NameIndex::key(const QString &dir, const QString &name)
+{
+    return QDir::cleanPath(dir + "/" + name).toLower();
+}
+
+QString NameIndex::reserve(const QString &dir, const QString &base, const QString &ext)
+{
+    Limit limit = limitFor(dir);
+
+    for (int n = 1; ; n++)
+    {
+        QString suffix = (n == 1) ? QString() : QString(" (%1)").arg(n);
+
+        QString name = base;
+        sanitizeFilename(name, limit.length - suffix.size(), limit.utf16Units);
+        if (name.isEmpty())
+            name = "download";
+        name += suffix;
+
+        if (taken.contains(key(dir, name)) || existsOnDisk(dir, name, ext)) { continue; }
+
+        taken.insert(key(dir, name));
+        return name;
+    }
+}
+
+void NameIndex::release(const QString &dir, const QString &name)
+{
+    taken.remove(key(dir, name));
+}
+
+void NameIndex::claim(const QString &dir, const QString &name)
+{
+    taken.insert(key(dir, name));
+}
+
+// yt-dlp skips a download whose final file is already there
+bool NameIndex::existsOnDisk(const QString &dir, const QString &name, const QString &ext) const
+{
+    QString stem = dir + "/" + name + ".";
+    if (!ext.isEmpty() && QFileInfo::exists(stem + ext)) { return true; }
+
+    static const QStringList media = {"mp4", "mkv", "webm", "mp3", "opus", "m4a"};
+    for (const QString &e : media)
+        if (e != ext && QFileInfo::exists(stem + e)) { return true; }
+    return false;
+}
+
+NameIndex::Limit NameIndex::limitFor(const QString &dir)
+{
+    auto it = limits.constFind(dir);
+    if (it != limits.constEnd()) { return *it; }
+
+    // subfolders from a template may not exist yet
+    QDir existing(dir);
+    while (!existing.exists() && existing.cdUp()) {}
+
+    Limit l;
+    QByteArray fs = QStorageInfo(existing.absolutePath()).fileSystemType().toLower();
+    if (fs == "ecryptfs")
+        l.length = 143;
+    else if (fs == "ntfs" || fs == "ntfs3" || fs == "fuseblk" || fs == "vfat" || fs == "msdos"
+             || fs == "exfat" || fs == "fat32" || fs == "hfs" || fs == "refs")
+        l.utf16Units = true;
+    l.length -= suffixReserve;
+
+#ifdef Q_OS_WIN
+    // without long path support the whole path has to stay under MAX_PATH
+    l.utf16Units = true;
+    l.length = qMin(l.length, 259 - int(QDir::toNativeSeparators(dir).size()) - 1 - suffixReserve);
+#endif
+
+    l.length = qMax(l.length, 16);
+    limits.insert(dir, l);
+    return l;
+}
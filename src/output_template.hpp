@@ -0,0 +1,96 @@
+#ifndef OUTPUT_TEMPLATE_HPP
+#define OUTPUT_TEMPLATE_HPP
+
+#include "download_request.hpp"
+#include "metadata_service.hpp"
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QList>
+
+
+// "{uploader}/{title} [{id}]": fields are title, uploader, id, extractor,
+// site, mode and date (the day it is queued); "/" makes subfolders. With
+// the video's metadata cached a pattern expands to the exact name,
+// otherwise it is handed to yt-dlp as its own %(field)s template.
+struct OutputRule
+{
+    QString site;       // HostScheduler::siteOf() form, empty for any
+    QString mode;       // video | audio, empty for any
+    QString pattern;    // a pattern, or the name of one
+};
+
+// Reusable named patterns and the rules picking one per site and mode,
+// read from a JSON file:
+//   {"templates": {"music": "{uploader} - {title}"},
+//    "rules": [{"site": "youtube.com", "mode": "audio", "template": "music"}]}
+// The first matching rule wins, the default pattern ("{title}") otherwise.
+class OutputTemplates
+{
+public:
+    bool load(const QString &path);
+    static QString defaultPath();
+
+    void setDefaultPattern(const QString &pattern);
+    QString defaultPattern() const { return fallback; }
+
+    void addTemplate(const QString &name, const QString &pattern) { named.insert(name, pattern); }
+    void addRule(const OutputRule &rule) { rules << rule; }
+
+    QString patternFor(const QString &url, const QString &mode) const;
+
+    // false when the pattern has a field nobody fills in
+    static bool isValid(const QString &pattern);
+
+    // path components relative to the output directory, every field
+    // sanitized on its own (a "/" in a title is no subfolder)
+    static QStringList expand(const QString &pattern, const VideoMetadata &md, const DownloadRequest &req);
+
+    // the same as a yt-dlp template, "%" escaped, without the extension
+    static QString toYtDlp(const QString &pattern, const DownloadRequest &req);
+
+private:
+    QString fallback = "{title}";
+    QHash<QString, QString> named;
+    QList<OutputRule> rules;
+};
+
+// Every file name handed out this session, so two jobs never get the same
+// one and an existing file is never overwritten: a taken name gets
+// " (2)", " (3)"... Names are compared case-insensitively and cut to the
+// limit of the file system they are written to.
+class NameIndex
+{
+public:
+    // a free name in dir for base, held until release(); ext is the final
+    // extension when known
+    QString reserve(const QString &dir, const QString &base, const QString &ext);
+    void release(const QString &dir, const QString &name);
+
+    // a name given by yt-dlp or an earlier run, not to be handed out
+    void claim(const QString &dir, const QString &name);
+
+    int size() const { return taken.size(); }
+
+private:
+    struct Limit
+    {
+        int length = 255;
+        bool utf16Units = false;
+    };
+
+    QSet<QString> taken;          // lowercased "dir/name", no extension
+    QHash<QString, Limit> limits; // per directory
+
+    Limit limitFor(const QString &dir);
+    bool existsOnDisk(const QString &dir, const QString &name, const QString &ext) const;
+
+    static QString key(const QString &dir, const QString &name);
+
+    // room for what yt-dlp appends, e.g. ".f399.webm.part" or ".temp.mkv"
+    static constexpr int suffixReserve = 24;
+};
+
+
+#endif // OUTPUT_TEMPLATE_HPP
@@ -0,0 +1,81 @@
+#include "performance_profile.hpp"
+
+#include <QSettings>
+#include <QThread>
+#include <QtGlobal>
+
+
+// ---------- Helper functions ----------
+// "auto" (or anything that is not a positive number) means auto
+static int parseFragments(const QVariant &v)
+{
+    bool ok = false;
+    int n = v.toString().toInt(&ok);
+    return ok ? qMax(0, n) : 0;
+}
+
+
+// ---------- PerformanceProfile ----------
+QStringList PerformanceProfile::arguments() const
+{
+    QStringList args;
+
+    if (!isAutoFragments())
+        args << "--concurrent-fragments" << QString::number(fragments);
+    if (!bufferSize.isEmpty())
+        args << "--buffer-size" << bufferSize;
+    if (!httpChunkSize.isEmpty())
+        args << "--http-chunk-size" << httpChunkSize;
+    if (retries >= 0)
+        args << "--retries" << QString::number(retries);
+    if (fragmentRetries >= 0)
+        args << "--fragment-retries" << QString::number(fragmentRetries);
+    if (!retrySleep.isEmpty())
+        args << "--retry-sleep" << "http:" + retrySleep
+             << "--retry-sleep" << "fragment:" + retrySleep;
+
+    return args;
+}
+
+int PerformanceProfile::autoFragments(int workers, int maxConnections)
+{
+    // fragments are network bound, two per core keeps the CPU out of the way
+    int budget = qMin(maxConnections, 2 * QThread::idealThreadCount());
+    return qBound(1, budget / qMax(1, workers), 16);
+}
+
+PerformanceProfile PerformanceProfile::fromSettings()
+{
+    QSettings s;
+    PerformanceProfile p;
+    p.fragments = parseFragments(s.value("fragments", "auto"));
+    p.bufferSize = s.value("buffer_size").toString();
+    p.httpChunkSize = s.value("http_chunk_size").toString();
+    p.retries = s.value("retries", -1).toInt();
+    p.fragmentRetries = s.value("fragment_retries", -1).toInt();
+    p.retrySleep = s.value("retry_sleep", p.retrySleep).toString();
+    return p;
+}
+
+PerformanceProfile PerformanceProfile::fromJson(const QJsonObject &o, const PerformanceProfile &defaults)
+{
+    PerformanceProfile p = defaults;
+    if (o.contains("fragments"))
+        p.fragments = parseFragments(o.value("fragments").toVariant());
+    p.bufferSize = o.value("buffer_size").toString(p.bufferSize);
+    p.httpChunkSize = o.value("http_chunk_size").toString(p.httpChunkSize);
+    p.retries = o.value("retries").toInt(p.retries);
+    p.fragmentRetries = o.value("fragment_retries").toInt(p.fragmentRetries);
+    p.retrySleep = o.value("retry_sleep").toString(p.retrySleep);
+    return p;
+}
+
+void PerformanceProfile::toJson(QJsonObject &o) const
+{
+    o.insert("fragments", isAutoFragments() ? QJsonValue("auto") : QJsonValue(fragments));
+    if (!bufferSize.isEmpty()) o.insert("buffer_size", bufferSize);
+    if (!httpChunkSize.isEmpty()) o.insert("http_chunk_size", httpChunkSize);
+    if (retries >= 0) o.insert("retries", retries);
+    if (fragmentRetries >= 0) o.insert("fragment_retries", fragmentRetries);
+    o.insert("retry_sleep", retrySleep);
+}
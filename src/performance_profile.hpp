@@ -0,0 +1,37 @@
+#ifndef PERFORMANCE_PROFILE_HPP
+#define PERFORMANCE_PROFILE_HPP
+
+#include <QString>
+#include <QStringList>
+#include <QJsonObject>
+
+
+// Transfer tuning for one job. Anything left at its default is not passed
+// to yt-dlp, so yt-dlp's own defaults apply.
+struct PerformanceProfile
+{
+    int fragments = 0;               // --concurrent-fragments, 0 = auto
+    QString bufferSize;              // --buffer-size, e.g. "16K"
+    QString httpChunkSize;           // --http-chunk-size, e.g. "10M"
+    int retries = -1;                // --retries
+    int fragmentRetries = -1;        // --fragment-retries
+    QString retrySleep = "exp=1:30"; // --retry-sleep for http and fragments
+
+    bool isAutoFragments() const { return fragments <= 0; }
+
+    // everything except -N when it is auto, that depends on the queue at launch time
+    QStringList arguments() const;
+
+    // splits a connection budget (2 per core, at most maxConnections)
+    // across the workers that can run at once
+    static int autoFragments(int workers, int maxConnections);
+
+    // keys: fragments ("auto" or a number), buffer_size, http_chunk_size,
+    // retries, fragment_retries, retry_sleep
+    static PerformanceProfile fromSettings();
+    static PerformanceProfile fromJson(const QJsonObject &o, const PerformanceProfile &defaults);
+    void toJson(QJsonObject &o) const;
+};
+
+
+#endif // PERFORMANCE_PROFILE_HPP
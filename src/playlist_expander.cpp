@@ -0,0 +1,108 @@
+#include "playlist_expander.hpp"
+
+#include <QProcess>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonArray>
+
+
+// ---------- PlaylistInfo ----------
+PlaylistInfo PlaylistInfo::fromYtDlpJson(const QJsonObject &o)
+{
+    PlaylistInfo info;
+    info.id = o.value("id").toString();
+    info.title = o.value("title").toString();
+
+    const QJsonArray entries = o.value("entries").toArray();
+    info.entries.reserve(entries.size());
+
+    int position = 0;
+    for (const QJsonValue &v : entries)
+    {
+        position++;
+        const QJsonObject e = v.toObject();
+
+        PlaylistEntry entry;
+        entry.index = position;
+        entry.id = e.value("id").toString();
+        entry.url = e.value("url").toString();
+        entry.title = e.value("title").toString();
+        entry.extractor = e.value("ie_key").toString();
+
+        // deleted/private videos show up without a url
+        if (entry.url.isEmpty()) { continue; }
+
+        info.entries.append(entry);
+    }
+
+    return info;
+}
+
+
+// ---------- PlaylistExpander ----------
+PlaylistExpander::PlaylistExpander(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString PlaylistExpander::indexPrefix(int index)
+{
+    return QString("%1 - ").arg(index, 3, 10, QChar('0'));
+}
+
+QSet<int> PlaylistExpander::existingIndices(const QString &dir)
+{
+    QSet<int> found;
+
+    const QStringList files = QDir(dir).entryList(QDir::Files);
+    for (const QString &name : files)
+    {
+        // partial downloads don't count
+        if (name.endsWith(".part") || name.endsWith(".ytdl") || name.contains(".part-Frag")
+            || name.contains(".temp."))
+            continue;
+
+        int sep = name.indexOf(" - ");
+        if (sep <= 0) { continue; }
+
+        bool ok = false;
+        int index = name.left(sep).toInt(&ok);
+        if (ok)
+            found.insert(index);
+    }
+
+    return found;
+}
+
+void PlaylistExpander::expand(const QString &url, const QStringList &extraArgs)
+{
+    QProcess* p = new QProcess(this);
+
+    connect(p, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+        this,
+        [=](int code, QProcess::ExitStatus status) {
+            QJsonDocument doc = QJsonDocument::fromJson(p->readAllStandardOutput());
+            if (status == QProcess::NormalExit && code == 0 && doc.isObject())
+            {
+                PlaylistInfo info = PlaylistInfo::fromYtDlpJson(doc.object());
+                info.url = url;
+                emit expanded(url, info);
+            }
+            else
+            {
+                emit failed(url, QString::fromLocal8Bit(p->readAllStandardError()).trimmed());
+            }
+            p->deleteLater();
+        });
+
+    connect(p, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+        if (error != QProcess::FailedToStart) { return; }
+
+        emit failed(url, "could not run yt-dlp");
+        p->deleteLater();
+    });
+
+    QStringList args = extraArgs;
+    args << "--flat-playlist" << "-J" << "--no-warnings" << url;
+    p->start(ytDlpPath, args);
+}
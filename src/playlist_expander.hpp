@@ -0,0 +1,56 @@
+#ifndef PLAYLIST_EXPANDER_HPP
+#define PLAYLIST_EXPANDER_HPP
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QSet>
+#include <QJsonObject>
+
+
+struct PlaylistEntry
+{
+    int index = 0;           // 1-based position, same as yt-dlp's playlist_index
+    QString id;
+    QString url;
+    QString title;
+    QString extractor;       // ie_key, e.g. "Youtube"
+};
+
+struct PlaylistInfo
+{
+    QString url;
+    QString id;
+    QString title;
+    QVector<PlaylistEntry> entries;
+
+    static PlaylistInfo fromYtDlpJson(const QJsonObject &o);
+};
+
+// Lists a playlist with a single "yt-dlp --flat-playlist -J" call so its
+// entries can be queued as independent jobs.
+class PlaylistExpander : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlaylistExpander(QObject *parent = nullptr);
+
+    void setProgram(const QString &program) { ytDlpPath = program; }
+    void expand(const QString &url, const QStringList &extraArgs = {});
+
+    // indices of "NNN - title.ext" files already completed in dir
+    static QSet<int> existingIndices(const QString &dir);
+    static QString indexPrefix(int index);
+
+signals:
+    void expanded(const QString &url, const PlaylistInfo &info);
+    void failed(const QString &url, const QString &error);
+
+private:
+    QString ytDlpPath;
+};
+
+
+#endif // PLAYLIST_EXPANDER_HPP
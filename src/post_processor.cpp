@@ -0,0 +1,281 @@
+#include "post_processor.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QDateTime>
+#include <QtEndian>
+
+
+// ---------- Helper functions ----------
+// a FLAC picture block, which is how ogg files carry cover art
+static QByteArray pictureBlock(const QByteArray &image, const QByteArray &mime)
+{
+    QByteArray out;
+    auto u32 = [&out](quint32 v) {
+        char bytes[4];
+        qToBigEndian(v, bytes);
+        out.append(bytes, 4);
+    };
+
+    u32(3);                          // front cover
+    u32(mime.size());
+    out += mime;
+    u32(0);                          // no description
+    u32(0); u32(0); u32(0); u32(0);  // size and colors, players read them from the image
+    u32(image.size());
+    out += image;
+    return out;
+}
+
+// ffmetadata escapes '=', ';', '#', '\' and newlines with a backslash
+static QByteArray escapeMetadata(const QByteArray &value)
+{
+    QByteArray out;
+    out.reserve(value.size() + 8);
+    for (char c : value)
+    {
+        if (c == '=' || c == ';' || c == '#' || c == '\\' || c == '\n')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+
+// ---------- PostProcessTask ----------
+QString PostProcessTask::output() const
+{
+    QFileInfo fi(input);
+    return fi.dir().filePath(fi.completeBaseName() + "." + format);
+}
+
+QStringList PostProcessTask::ffmpegArgs(const QString &outputPath, const QString &coverMetadata) const
+{
+    // info level only for the "bench:" line, the rest is not shown unless it fails
+    QStringList args{"-hide_banner", "-nostdin", "-nostats", "-loglevel", "info", "-benchmark", "-y", "-i", input};
+
+    // ogg has no cover art stream, opus gets the thumbnail as a comment instead
+    bool cover = (format == "mp3") && !thumbnail.isEmpty();
+    if (cover)
+        args << "-i" << thumbnail;
+    else if (!coverMetadata.isEmpty())
+        args << "-f" << "ffmetadata" << "-i" << coverMetadata;
+
+    args << "-map" << "0:a:0";
+    if (cover)
+        args << "-map" << "1:v:0" << "-c:v" << "mjpeg" << "-disposition:v" << "attached_pic";
+
+    // --- audio ---
+    if (copy && !loudnorm)
+    {
+        args << "-c:a" << "copy";
+    }
+    else
+    {
+        if (loudnorm)
+            args << "-af" << "loudnorm=I=-16:TP=-1.5:LRA=11";
+        args << audioEncoderArgs(format, audioQuality, settings);
+    }
+
+    if (format == "mp3")
+        args << "-id3v2_version" << "3";
+
+    // the tags of the source, plus the picture comment
+    args << "-map_metadata" << "0";
+    if (!cover && !coverMetadata.isEmpty())
+        args << "-map_metadata" << "1";
+    args << outputPath;
+    return args;
+}
+
+
+// ---------- PostProcessor ----------
+PostProcessor::PostProcessor(QObject *parent)
+    : QObject(parent)
+{
+    workerLimit = qMax(1, QThread::idealThreadCount());
+}
+
+void PostProcessor::setMaxWorkers(int n)
+{
+    workerLimit = qMax(1, n);
+    schedule();
+}
+
+void PostProcessor::submit(const PostProcessTask &task)
+{
+    pending.append(task);
+    schedule();
+}
+
+bool PostProcessor::isQueued(int jobId) const
+{
+    for (const PostProcessTask &t : pending)
+        if (t.jobId == jobId) { return true; }
+    for (const Worker &w : workers)
+        if (w.task.jobId == jobId) { return true; }
+    return false;
+}
+
+void PostProcessor::cancelAll()
+{
+    const QList<PostProcessTask> waiting = pending;
+    pending.clear();
+    for (const PostProcessTask &t : waiting)
+        emit taskFinished(t.jobId, false, "canceled", PostProcessReport());
+
+    // ffmpeg has no children of its own, a kill is enough
+    const QList<QProcess*> running = workers.keys();
+    for (QProcess* p : running)
+    {
+        p->disconnect(this);
+        p->kill();
+        finish(p, false, "canceled");
+    }
+}
+
+// "bench: utime=0.123s stime=0.010s rtime=0.200s"
+double PostProcessor::cpuSecondsFrom(const QByteArray &output)
+{
+    int i = output.lastIndexOf("bench: utime=");
+    if (i < 0) { return -1; }
+
+    QList<QByteArray> fields = output.mid(i + 7, output.indexOf('\n', i) - i - 7).split(' ');
+    double seconds = 0;
+    for (const QByteArray &f : fields)
+    {
+        if (f.startsWith("utime=") || f.startsWith("stime="))
+            seconds += f.mid(6).chopped(f.endsWith('s') ? 1 : 0).toDouble();
+    }
+    return seconds;
+}
+
+QString PostProcessor::lastLines(const QByteArray &output, int n)
+{
+    QStringList lines = QString::fromLocal8Bit(output).split('\n', Qt::SkipEmptyParts);
+    return lines.mid(qMax(0, lines.size() - n)).join(" / ").trimmed();
+}
+
+QString PostProcessor::tempPathFor(const QString &output)
+{
+    QFileInfo fi(output);
+    return fi.dir().filePath(fi.completeBaseName() + ".temp." + fi.suffix());
+}
+
+// METADATA_BLOCK_PICTURE as an ffmetadata file, too large for a -metadata argument
+bool PostProcessor::writeCoverMetadata(const QString &image, const QString &path)
+{
+    QFile in(image);
+    if (!in.open(QIODevice::ReadOnly)) { return false; }
+
+    QString ext = QFileInfo(image).suffix().toLower();
+    QByteArray mime = (ext == "jpg" || ext == "jpeg") ? "image/jpeg" : "image/" + ext.toLatin1();
+    QByteArray block = pictureBlock(in.readAll(), mime).toBase64();
+
+    QFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) { return false; }
+    QByteArray contents = ";FFMETADATA1\nMETADATA_BLOCK_PICTURE=" + escapeMetadata(block) + "\n";
+    return out.write(contents) == contents.size();
+}
+
+void PostProcessor::schedule()
+{
+    while (workers.size() < workerLimit && !pending.isEmpty())
+        start(pending.takeFirst());
+}
+
+void PostProcessor::start(const PostProcessTask &task)
+{
+    Worker w;
+    w.task = task;
+    w.tempPath = tempPathFor(task.output());
+    w.startedAt = QDateTime::currentMSecsSinceEpoch();
+
+    if (task.format == "opus" && !task.thumbnail.isEmpty())
+    {
+        w.metadataPath = w.tempPath + ".ffmeta";
+        if (!writeCoverMetadata(task.thumbnail, w.metadataPath))
+            w.metadataPath.clear();
+    }
+
+    QProcess* p = new QProcess(this);
+    p->setProcessChannelMode(QProcess::MergedChannels);
+    workers.insert(p, w);
+
+    connect(p, &QProcess::readyReadStandardOutput, this, [=] {
+        auto it = workers.find(p);
+        if (it != workers.end())
+            it->output += p->readAllStandardOutput();
+    });
+
+    connect(p, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+        this,
+        [=](int code, QProcess::ExitStatus status) {
+            auto it = workers.find(p);
+            if (it != workers.end())
+                it->output += p->readAllStandardOutput();
+
+            bool ok = (status == QProcess::NormalExit && code == 0);
+            QString error = lastLines(workers.value(p).output, 3);
+            finish(p, ok, ok ? QString() : (error.isEmpty() ? QString("ffmpeg exited with code %1").arg(code) : error));
+        });
+
+    // finished() is never emitted when the binary cannot be launched
+    connect(p, &QProcess::errorOccurred, this, [=](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            finish(p, false, "ffmpeg could not be started: " + ffmpeg);
+    });
+
+    emit taskStarted(task.jobId);
+    p->start(ffmpeg, task.ffmpegArgs(w.tempPath, w.metadataPath));
+}
+
+void PostProcessor::finish(QProcess *p, bool ok, const QString &message)
+{
+    if (!workers.contains(p)) { return; }
+    Worker w = workers.take(p);
+    p->disconnect(this);
+    p->deleteLater();
+    if (!w.metadataPath.isEmpty())
+        QFile::remove(w.metadataPath);
+
+    QString output = w.task.output();
+    QString result = message;
+    // yt-dlp only knew the downloaded name, a file already holding the
+    // converted one belongs to someone else
+    if (ok && !w.task.replace && output != w.task.input && QFileInfo::exists(output))
+    {
+        ok = false;
+        result = output + " already exists";
+    }
+    if (ok)
+    {
+        // swapped in only now, a failed run never leaves a broken file behind
+        QFile::remove(output);
+        ok = QFile::rename(w.tempPath, output);
+        if (!ok)
+            result = "Could not write " + output;
+    }
+
+    if (ok)
+    {
+        if (w.task.input != output)
+            QFile::remove(w.task.input);
+        if (!w.task.thumbnail.isEmpty())
+            QFile::remove(w.task.thumbnail);
+    }
+    else
+    {
+        QFile::remove(w.tempPath);
+    }
+
+    PostProcessReport report;
+    report.copied = w.task.copy && !w.task.loudnorm;
+    report.cpuSeconds = cpuSecondsFrom(w.output);
+    report.wallSeconds = (QDateTime::currentMSecsSinceEpoch() - w.startedAt) / 1000.0;
+
+    emit taskFinished(w.task.jobId, ok, ok ? output : result, report);
+    schedule();
+}
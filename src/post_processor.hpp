@@ -0,0 +1,87 @@
+#ifndef POST_PROCESSOR_HPP
+#define POST_PROCESSOR_HPP
+
+#include "transcode_planner.hpp"
+#include <QObject>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+
+
+// One conversion after a raw download: audio extraction or remux, the
+// thumbnail embedded as cover art (mp3) and optional loudness normalisation.
+struct PostProcessTask
+{
+    int jobId = 0;
+    QString input;           // what yt-dlp downloaded
+    QString thumbnail;       // written by --write-thumbnail, may be empty
+    QString format;          // mp3 | opus
+    QString audioQuality;    // 128k ... 320k, Best
+    bool loudnorm = false;
+    bool copy = false;       // the source codec already is the target, see planAudio()
+    bool replace = false;    // output() was reserved for this job, an existing file may go
+    TranscodeSettings settings;
+
+    // input with the target extension
+    QString output() const;
+    // coverMetadata: an ffmetadata file holding opus cover art, see writeCoverMetadata()
+    QStringList ffmpegArgs(const QString &outputPath, const QString &coverMetadata = {}) const;
+};
+
+// what a finished task cost, as reported by ffmpeg's -benchmark
+struct PostProcessReport
+{
+    bool copied = false;
+    double cpuSeconds = -1;  // user + system, -1 when ffmpeg did not say
+    double wallSeconds = 0;
+};
+
+// ffmpeg worker pool, sized to the CPU rather than to the download slots,
+// so conversions never hold up a network transfer and the other way round.
+// Output goes to a ".temp." file that only replaces the target once ffmpeg
+// succeeded; the raw download and thumbnail are removed after that.
+class PostProcessor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PostProcessor(QObject *parent = nullptr);
+
+    void setProgram(const QString &ffmpegPath) { ffmpeg = ffmpegPath; }
+    void setMaxWorkers(int n);
+    int maxWorkers() const { return workerLimit; }
+
+    void submit(const PostProcessTask &task);
+    void cancelAll();
+
+    int runningCount() const { return workers.size(); }
+    int pendingCount() const { return pending.size(); }
+    bool isIdle() const { return workers.isEmpty() && pending.isEmpty(); }
+    bool isQueued(int jobId) const;
+
+signals:
+    void taskStarted(int jobId);
+    void taskFinished(int jobId, bool ok, const QString &message, const PostProcessReport &report);
+
+private:
+    QString ffmpeg;
+    int workerLimit = 1;
+
+    QList<PostProcessTask> pending;
+    struct Worker { PostProcessTask task; QString tempPath; QString metadataPath; QByteArray output; qint64 startedAt = 0; };
+    QHash<QProcess*, Worker> workers;
+
+    void schedule();
+    void start(const PostProcessTask &task);
+    void finish(QProcess *p, bool ok, const QString &message);
+
+    static QString tempPathFor(const QString &output);
+    static bool writeCoverMetadata(const QString &image, const QString &path);
+    static double cpuSecondsFrom(const QByteArray &output);
+    static QString lastLines(const QByteArray &output, int n);
+};
+
+
+#endif // POST_PROCESSOR_HPP
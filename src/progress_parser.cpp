@@ -0,0 +1,153 @@
+#include "progress_parser.hpp"
+
+#include <QStringView>
+
+
+static const QString downloadTag = "[ytgui-dl] ";
+static const QString postprocessTag = "[ytgui-pp] ";
+
+
+// ---------- Helper functions ----------
+// yt-dlp prints "NA" for fields it does not know
+static qint64 toBytes(QStringView v)
+{
+    bool ok = false;
+    double d = v.toDouble(&ok);
+    return ok ? static_cast<qint64>(d) : -1;
+}
+
+static int toInt(QStringView v)
+{
+    bool ok = false;
+    double d = v.toDouble(&ok);
+    return ok ? static_cast<int>(d) : -1;
+}
+
+QString formatBytes(double bytes)
+{
+    if (bytes < 0) { return "?"; }
+
+    static const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int u = 0;
+    while (bytes >= 1024.0 && u < 4)
+    {
+        bytes /= 1024.0;
+        u++;
+    }
+    return QString::number(bytes, 'f', u == 0 ? 0 : 2) + " " + units[u];
+}
+
+QString formatDuration(int seconds)
+{
+    if (seconds < 0) { return "--:--"; }
+
+    int h = seconds / 3600;
+    int m = (seconds / 60) % 60;
+    int s = seconds % 60;
+
+    if (h > 0)
+        return QString("%1:%2:%3").arg(h).arg(m, 2, 10, QChar('0')).arg(s, 2, 10, QChar('0'));
+    return QString("%1:%2").arg(m, 2, 10, QChar('0')).arg(s, 2, 10, QChar('0'));
+}
+
+
+// ---------- ProgressEvent ----------
+double ProgressEvent::percent() const
+{
+    if (kind == Kind::PostProcess) { return -1; }
+    if (status == "finished") { return 100.0; }
+
+    if (totalBytes > 0 && downloadedBytes >= 0)
+        return qMin(100.0, 100.0 * downloadedBytes / totalBytes);
+
+    if (fragmentCount > 0 && fragmentIndex >= 0)
+        return qMin(100.0, 100.0 * fragmentIndex / fragmentCount);
+
+    return -1;
+}
+
+QString ProgressEvent::describe() const
+{
+    if (kind == Kind::PostProcess)
+        return QString("post-processing: %1 (%2)").arg(postprocessor, status);
+
+    QStringList parts;
+
+    double p = percent();
+    parts << (p >= 0 ? QString::number(p, 'f', 1) + "%" : status);
+
+    if (totalBytes > 0)
+        parts << "of " + formatBytes(totalBytes);
+    if (speed >= 0)
+        parts << "at " + formatBytes(speed) + "/s";
+    if (eta >= 0)
+        parts << "ETA " + formatDuration(eta);
+    if (fragmentCount > 0)
+        parts << QString("(frag %1/%2)").arg(fragmentIndex).arg(fragmentCount);
+
+    return parts.join("  ");
+}
+
+
+// ---------- ProgressParser ----------
+QStringList ProgressParser::arguments()
+{
+    return {
+        "--newline",
+        "--progress",
+        "--progress-template",
+        "download:" + downloadTag
+            + "%(progress.status)s|%(progress.downloaded_bytes)s|%(progress.total_bytes)s"
+              "|%(progress.total_bytes_estimate)s|%(progress.speed)s|%(progress.eta)s"
+              "|%(progress.fragment_index)s|%(progress.fragment_count)s"
+              "|%(info.extractor_key)s|%(info.id)s",
+        "--progress-template",
+        "postprocess:" + postprocessTag + "%(progress.status)s|%(progress.postprocessor)s",
+    };
+}
+
+bool ProgressParser::parse(const QString &line, ProgressEvent &ev)
+{
+    if (line.startsWith(downloadTag))
+    {
+        const QList<QStringView> f = QStringView(line).mid(downloadTag.size()).split(u'|');
+        if (f.size() < 8) { return false; }
+
+        ev = ProgressEvent();
+        ev.kind = ProgressEvent::Kind::Download;
+        ev.status = f[0].toString();
+        ev.downloadedBytes = toBytes(f[1]);
+        ev.totalBytes = toBytes(f[2]);
+        if (ev.totalBytes < 0)
+            ev.totalBytes = toBytes(f[3]);
+
+        bool ok = false;
+        double speed = f[4].toDouble(&ok);
+        ev.speed = ok ? speed : -1;
+
+        ev.eta = toInt(f[5]);
+        ev.fragmentIndex = toInt(f[6]);
+        ev.fragmentCount = toInt(f[7]);
+
+        if (f.size() >= 10)
+        {
+            ev.extractor = f[8].toString();
+            ev.videoId = f[9].toString();
+        }
+        return true;
+    }
+
+    if (line.startsWith(postprocessTag))
+    {
+        const QList<QStringView> f = QStringView(line).mid(postprocessTag.size()).split(u'|');
+        if (f.size() < 2) { return false; }
+
+        ev = ProgressEvent();
+        ev.kind = ProgressEvent::Kind::PostProcess;
+        ev.status = f[0].toString();
+        ev.postprocessor = f[1].toString();
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,48 @@
+#ifndef PROGRESS_PARSER_HPP
+#define PROGRESS_PARSER_HPP
+
+#include <QString>
+#include <QStringList>
+
+
+struct ProgressEvent
+{
+    enum class Kind { Download, PostProcess };
+
+    Kind kind = Kind::Download;
+    QString status;          // downloading / finished / error, or started / processing / finished for post-processors
+
+    qint64 downloadedBytes = -1;
+    qint64 totalBytes = -1;  // exact size when known, yt-dlp's estimate otherwise
+    double speed = -1;       // bytes per second
+    int eta = -1;            // seconds
+    int fragmentIndex = -1;
+    int fragmentCount = -1;
+
+    QString postprocessor;   // e.g. "Merger", "ExtractAudio"
+
+    // what is being downloaded, in download archive terms
+    QString extractor;       // extractor key, e.g. "Youtube"
+    QString videoId;
+
+    // 0..100, or -1 when yt-dlp gave nothing to compute it from
+    double percent() const;
+
+    // one-line human readable summary for status rows
+    QString describe() const;
+};
+
+// yt-dlp is told to print progress as machine readable lines (see
+// arguments()); everything else it prints is a regular log line.
+class ProgressParser
+{
+public:
+    static QStringList arguments();
+    static bool parse(const QString &line, ProgressEvent &ev);
+};
+
+QString formatBytes(double bytes);
+QString formatDuration(int seconds);
+
+
+#endif // PROGRESS_PARSER_HPP
@@ -0,0 +1,76 @@
+#include "queue_view.hpp"
+
+#include <QTableView>
+#include <QHeaderView>
+#include <QComboBox>
+#include <QLineEdit>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+
+
+QueueView::QueueView(DownloadQueue *queue, PostProcessor *post, QWidget *parent)
+    : QWidget(parent)
+{
+    jobs = new JobTableModel(queue, post, this);
+    filter = new JobFilterModel(this);
+    filter->setSourceModel(jobs);
+
+    // --- filters ---
+    cbState = new QComboBox;
+    cbState->addItem("All states", QString());
+    for (const char *state : {"queued", "running", "converting", "finished", "failed", "canceled"})
+        cbState->addItem(state, QString(state));
+    cbState->setFixedSize(160, 30);
+
+    leFilter = new QLineEdit;
+    leFilter->setPlaceholderText("Filter by site or URL");
+    leFilter->setClearButtonEnabled(true);
+    leFilter->setFixedHeight(30);
+
+    connect(cbState, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this] {
+        filter->setStateFilter(cbState->currentData().toString());
+    });
+
+    // refiltering 10k rows per keystroke is wasted work
+    filterDelay.setSingleShot(true);
+    filterDelay.setInterval(150);
+    connect(&filterDelay, &QTimer::timeout, this, [this] { filter->setTextFilter(leFilter->text()); });
+    connect(leFilter, &QLineEdit::textChanged, &filterDelay, QOverload<>::of(&QTimer::start));
+
+    QHBoxLayout* filters = new QHBoxLayout;
+    filters->addWidget(cbState);
+    filters->addWidget(leFilter);
+
+    // --- table ---
+    table = new QTableView;
+    table->setModel(filter);
+    table->setSortingEnabled(true);
+    table->sortByColumn(JobTableModel::Id, Qt::AscendingOrder);
+    table->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setShowGrid(false);
+    table->setWordWrap(false);
+    table->setMinimumHeight(200);
+
+    // fixed sizes: nothing is measured per row, whatever the row count
+    table->verticalHeader()->setVisible(false);
+    table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    table->verticalHeader()->setDefaultSectionSize(24);
+
+    QHeaderView* header = table->horizontalHeader();
+    header->setSectionResizeMode(QHeaderView::Interactive);
+    header->setSectionResizeMode(JobTableModel::Url, QHeaderView::Stretch);
+    header->resizeSection(JobTableModel::Id, 60);
+    header->resizeSection(JobTableModel::State, 100);
+    header->resizeSection(JobTableModel::Site, 140);
+    header->resizeSection(JobTableModel::Progress, 80);
+    header->resizeSection(JobTableModel::Speed, 100);
+    header->resizeSection(JobTableModel::Eta, 70);
+    header->resizeSection(JobTableModel::Size, 90);
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addLayout(filters);
+    layout->addWidget(table);
+    setLayout(layout);
+}
@@ -0,0 +1,36 @@
+#ifndef QUEUE_VIEW_HPP
+#define QUEUE_VIEW_HPP
+
+#include "job_table_model.hpp"
+#include <QWidget>
+#include <QTimer>
+
+class QTableView;
+class QComboBox;
+class QLineEdit;
+
+
+// Every job of the session in one table, filterable by state and by site
+// or URL, sortable by any column. Rows have a fixed height, so the view
+// lays out and paints only the ones on screen.
+class QueueView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    QueueView(DownloadQueue *queue, PostProcessor *post, QWidget *parent = nullptr);
+
+    JobTableModel* model() const { return jobs; }
+
+private:
+    JobTableModel* jobs;
+    JobFilterModel* filter;
+
+    QTableView* table;
+    QComboBox* cbState;
+    QLineEdit* leFilter;
+    QTimer filterDelay;
+};
+
+
+#endif // QUEUE_VIEW_HPP
@@ -0,0 +1,177 @@
+#include "theme_engine.hpp"
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QDebug>
+#include <utility>
+
+
+// ---------- Helper functions ----------
+static QString readFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning() << "Could not load stylesheet file:" << path;
+        return {};
+    }
+    return QString::fromUtf8(file.readAll());
+}
+
+static bool isNameChar(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_' || c == '-';
+}
+
+
+// ---------- ThemeEngine ----------
+ThemeEngine& ThemeEngine::instance()
+{
+    static ThemeEngine engine;
+    return engine;
+}
+
+ThemeEngine::ThemeEngine()
+{
+    compile(readFile(":/qss/style.qss"));
+
+    QHash<QString, QString> dark = parseVariables(readFile(":/qss/dark_var.qss"));
+    dark.insert("icon_down_arrow", ":/icons/down_arrow_dark.png");
+    dark.insert("moon_icon", ":/icons/moon_dark.png");
+    dark.insert("sun_icon", ":/icons/sun_dark.png");
+
+    QHash<QString, QString> light = parseVariables(readFile(":/qss/light_var.qss"));
+    light.insert("icon_down_arrow", ":/icons/down_arrow_light.png");
+    light.insert("moon_icon", ":/icons/moon_light.png");
+    light.insert("sun_icon", ":/icons/sun_light.png");
+
+    variables.insert("dark", dark);
+    variables.insert("light", light);
+}
+
+QString ThemeEngine::nameOf(Theme theme)
+{
+    return theme == Theme::Light ? "light" : "dark";
+}
+
+QString ThemeEngine::userThemesDir()
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("themes");
+}
+
+void ThemeEngine::compile(const QString &style)
+{
+    source = style;
+    pieces.clear();
+    slotNames.clear();
+
+    QHash<QString, int> slotOf;
+    int literalStart = 0;
+    int i = 0;
+    while ((i = source.indexOf('@', i)) >= 0)
+    {
+        int end = i + 1;
+        while (end < source.size() && isNameChar(source[end]))
+            end++;
+        if (end == i + 1)
+        {
+            i = end;
+            continue;
+        }
+
+        QString name = source.mid(i + 1, end - i - 1);
+        auto it = slotOf.constFind(name);
+        if (it == slotOf.constEnd())
+        {
+            it = slotOf.insert(name, slotNames.size());
+            slotNames << name;
+        }
+
+        pieces.append({literalStart, i - literalStart, it.value()});
+        literalStart = i = end;
+    }
+    pieces.append({literalStart, int(source.size()) - literalStart, -1});
+}
+
+QHash<QString, QString> ThemeEngine::parseVariables(const QString &text, QString *base)
+{
+    QHash<QString, QString> out;
+    const QStringList lines = text.split('\n');
+    for (QString line : lines)
+    {
+        line = line.trimmed();
+        if (line.endsWith(';'))
+            line.chop(1);
+
+        // "@define-color name value" and "@extends light"
+        QStringList parts = line.split(' ', Qt::SkipEmptyParts);
+        if (parts.size() >= 3 && parts[0] == "@define-color")
+            out.insert(parts[1], parts.mid(2).join(' '));
+        else if (parts.size() == 2 && parts[0] == "@extends" && base)
+            *base = parts[1];
+    }
+    return out;
+}
+
+QString ThemeEngine::render(const QString &name)
+{
+    auto cached = cache.constFind(name);
+    if (cached != cache.constEnd()) { return cached.value(); }
+
+    auto vars = variables.constFind(name);
+    if (vars == variables.constEnd()) { return {}; }
+
+    // values by slot, resolved once per render rather than per occurrence
+    QVector<QString> values(slotNames.size());
+    qsizetype length = source.size();
+    for (int s = 0; s < slotNames.size(); s++)
+    {
+        auto v = vars->constFind(slotNames[s]);
+        values[s] = (v != vars->constEnd()) ? v.value() : '@' + slotNames[s];
+        length += values[s].size();
+    }
+
+    QString out;
+    out.reserve(length);
+    for (const Piece &p : std::as_const(pieces))
+    {
+        out.append(QStringView(source).mid(p.start, p.length));
+        if (p.slot >= 0)
+            out.append(values[p.slot]);
+    }
+
+    cache.insert(name, out);
+    return out;
+}
+
+int ThemeEngine::loadUserThemes(const QString &dir)
+{
+    const QFileInfoList files = QDir(dir).entryInfoList({"*.qss"}, QDir::Files, QDir::Name);
+    int loaded = 0;
+    for (const QFileInfo &fi : files)
+    {
+        QString base = "dark";
+        QHash<QString, QString> vars = parseVariables(readFile(fi.absoluteFilePath()), &base);
+        if (vars.isEmpty()) { continue; }
+
+        QString name = fi.completeBaseName().toLower();
+        if (name == "dark" || name == "light")
+            base = name;
+        if (!variables.contains(base))
+        {
+            qWarning() << "Theme" << fi.fileName() << "extends unknown theme" << base;
+            continue;
+        }
+
+        // missing values come from the base, so a theme can change just one color
+        QHash<QString, QString> merged = variables.value(base);
+        for (auto it = vars.constBegin(); it != vars.constEnd(); ++it)
+            merged.insert(it.key(), it.value());
+
+        variables.insert(name, merged);
+        cache.remove(name);
+        loaded++;
+    }
+    return loaded;
+}
@@ -0,0 +1,59 @@
+#ifndef THEME_ENGINE_HPP
+#define THEME_ENGINE_HPP
+
+#include "style_loader.hpp"
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+
+
+// style.qss is parsed once into literal runs and @variable slots; a theme
+// is rendered by filling the slots in a single pass and kept per theme
+// name, so switching back and forth never touches the resources again.
+// User themes are "<name>.qss" files of "@define-color name value;" lines:
+// dark.qss and light.qss override the built-in values, any other name is
+// a new theme based on dark, or on light with an "@extends light;" line.
+class ThemeEngine
+{
+public:
+    static ThemeEngine& instance();
+
+    static QString nameOf(Theme theme);
+    static QString userThemesDir();
+
+    QStringList themes() const { return variables.keys(); }
+    bool hasTheme(const QString &name) const { return variables.contains(name); }
+
+    // the finished stylesheet, an empty one for unknown themes
+    QString render(const QString &name);
+
+    // returns how many themes were read
+    int loadUserThemes(const QString &dir);
+
+    // for benchmarks: the next render() of every theme starts over
+    void clearCache() { cache.clear(); }
+
+private:
+    ThemeEngine();
+
+    // a literal run of the template followed by one variable slot (-1 for none)
+    struct Piece
+    {
+        int start = 0;
+        int length = 0;
+        int slot = -1;
+    };
+
+    QString source;
+    QVector<Piece> pieces;
+    QStringList slotNames;
+    QHash<QString, QHash<QString, QString>> variables;
+    QHash<QString, QString> cache;
+
+    void compile(const QString &style);
+    static QHash<QString, QString> parseVariables(const QString &text, QString *base = nullptr);
+};
+
+
+#endif // THEME_ENGINE_HPP
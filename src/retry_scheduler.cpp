@@ -0,0 +1,138 @@
+#include "retry_scheduler.hpp"
+
+#include <QSettings>
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QUrl>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+
+// ---------- RetryPolicy ----------
+int RetryPolicy::delayMs(int attempt, const Failure &failure) const
+{
+    qint64 base = qint64(failure.kind == FailureKind::RateLimited ? rateLimitDelay : baseDelay) * 1000;
+    qint64 cap = qint64(qMax(maxDelay, 1)) * 1000;
+
+    qint64 d = qMin(cap, base << qBound(0, attempt - 1, 20));
+
+    // half fixed, half random, so jobs that failed together don't come back together
+    d = d / 2 + QRandomGenerator::global()->bounded(d / 2 + 1);
+
+    // the server's own Retry-After wins over the guess
+    if (failure.retryAfter > 0)
+        d = qMax(d, qint64(failure.retryAfter) * 1000);
+    return static_cast<int>(d);
+}
+
+RetryPolicy RetryPolicy::fromSettings()
+{
+    QSettings settings;
+    RetryPolicy p;
+    p.maxAttempts = qMax(0, settings.value("retry_max_attempts", p.maxAttempts).toInt());
+    p.baseDelay = qMax(1, settings.value("retry_base_delay", p.baseDelay).toInt());
+    p.maxDelay = qMax(p.baseDelay, settings.value("retry_max_delay", p.maxDelay).toInt());
+    p.rateLimitDelay = qMax(1, settings.value("retry_rate_limit_delay", p.rateLimitDelay).toInt());
+    return p;
+}
+
+
+// ---------- RetryScheduler ----------
+RetryScheduler::RetryScheduler(DownloadQueue *queue, QObject *parent)
+    : QObject(parent), queue(queue)
+{
+    timer.setSingleShot(true);
+    connect(&timer, &QTimer::timeout, this, &RetryScheduler::fire);
+}
+
+bool RetryScheduler::handle(int id, const Failure &failure)
+{
+    const DownloadJob* j = queue->job(id);
+    int attempt = attemptCount.value(id) + 1;
+    if (!j || !failure.retryable() || attempt > rules.maxAttempts)
+    {
+        forget(id);
+        return false;
+    }
+    attemptCount.insert(id, attempt);
+
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 due = now + rules.delayMs(attempt, failure);
+
+    QString host = QUrl(j->url).host();
+    qint64 &slot = hostNextSlot[host];
+    if (failure.kind == FailureKind::RateLimited)
+    {
+        // every retry to this host waits at least as long as this one
+        for (auto it = waiting.begin(); it != waiting.end(); ++it)
+            if (QUrl(queue->job(it.key())->url).host() == host)
+                it.value() = qMax(it.value(), due);
+        slot = qMax(slot, due);
+    }
+    due = qMax(due, slot);
+    slot = due + hostSpacingMs;
+
+    waiting.insert(id, due);
+    arm();
+
+    emit retryScheduled(id, attempt, static_cast<int>(due - now), failure);
+    return true;
+}
+
+void RetryScheduler::forget(int id)
+{
+    attemptCount.remove(id);
+    waiting.remove(id);
+}
+
+QList<int> RetryScheduler::cancelAll()
+{
+    QList<int> ids = waiting.keys();
+    for (int id : ids)
+        forget(id);
+    timer.stop();
+    return ids;
+}
+
+void RetryScheduler::arm()
+{
+    if (waiting.isEmpty())
+    {
+        timer.stop();
+        return;
+    }
+
+    qint64 next = std::numeric_limits<qint64>::max();
+    for (qint64 due : std::as_const(waiting))
+        next = qMin(next, due);
+
+    timer.start(static_cast<int>(qMax<qint64>(0, next - QDateTime::currentMSecsSinceEpoch())));
+}
+
+void RetryScheduler::fire()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    QList<int> due;
+    for (auto it = waiting.constBegin(); it != waiting.constEnd(); ++it)
+        if (it.value() <= now)
+            due << it.key();
+    std::sort(due.begin(), due.end());
+
+    for (int id : due)
+    {
+        waiting.remove(id);
+        if (queue->retry(id))
+            emit retryStarted(id);
+        else
+            qWarning() << "Job" << id << "could not be retried";
+    }
+
+    // slots in the past are no use to anyone
+    for (auto it = hostNextSlot.begin(); it != hostNextSlot.end(); )
+        it = it.value() < now ? hostNextSlot.erase(it) : std::next(it);
+
+    arm();
+}
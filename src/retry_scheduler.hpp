@@ -0,0 +1,73 @@
+#ifndef RETRY_SCHEDULER_HPP
+#define RETRY_SCHEDULER_HPP
+
+#include "download_queue.hpp"
+#include "failure_classifier.hpp"
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QList>
+
+
+struct RetryPolicy
+{
+    int maxAttempts = 3;        // retries per job, 0 disables
+    int baseDelay = 5;          // seconds, doubled per attempt
+    int maxDelay = 300;
+    int rateLimitDelay = 60;    // first wait after an HTTP 429
+
+    // the wait before retry number "attempt" (1-based), jitter included
+    int delayMs(int attempt, const Failure &failure) const;
+
+    static RetryPolicy fromSettings();
+};
+
+// Puts failed jobs back into the queue after an exponential backoff
+// with jitter, for failures the classifier calls transient. Retries to
+// one host are spread out, and a 429 holds back every retry to that
+// host until its wait is over. Other jobs keep running meanwhile.
+class RetryScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RetryScheduler(DownloadQueue *queue, QObject *parent = nullptr);
+
+    void setPolicy(const RetryPolicy &p) { rules = p; }
+    const RetryPolicy& policy() const { return rules; }
+
+    // called for a job that just failed, true when a retry is scheduled
+    bool handle(int id, const Failure &failure);
+
+    // the job finished for good, its attempts are not needed any more
+    void forget(int id);
+
+    bool isWaiting(int id) const { return waiting.contains(id); }
+    bool isIdle() const { return waiting.isEmpty(); }
+    int attempts(int id) const { return attemptCount.value(id); }
+
+    // drops every scheduled retry, returns the jobs that were waiting
+    QList<int> cancelAll();
+
+signals:
+    void retryScheduled(int id, int attempt, int delayMs, const Failure &failure);
+    void retryStarted(int id);
+
+private:
+    DownloadQueue* queue;
+    RetryPolicy rules;
+
+    QHash<int, int> attemptCount;
+    QHash<int, qint64> waiting;          // job id -> due, ms since epoch
+    QHash<QString, qint64> hostNextSlot; // earliest next retry per host
+    QTimer timer;
+
+    void arm();
+    void fire();
+
+    // retries to the same host are at least this far apart
+    static constexpr qint64 hostSpacingMs = 2000;
+};
+
+
+#endif // RETRY_SCHEDULER_HPP
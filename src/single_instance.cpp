@@ -0,0 +1,115 @@
+#include "single_instance.hpp"
+
+#include <QLocalSocket>
+#include <QCoreApplication>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+
+// ---------- SingleInstance ----------
+SingleInstance::SingleInstance(QObject *parent)
+    : QObject(parent)
+{
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&server, &QLocalServer::newConnection, this, &SingleInstance::accept);
+}
+
+// per user, a pipe name on Windows and a socket in the temp dir elsewhere
+QString SingleInstance::serverName()
+{
+    QString user = qEnvironmentVariable("USER", qEnvironmentVariable("USERNAME"));
+    return QCoreApplication::applicationName() + '-' + user;
+}
+
+// runs before the event loop and before any window, so waiting here
+// blocks nothing; the running instance answers "ok" once it has the URLs
+bool SingleInstance::forward(const QStringList &urls)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+    if (!socket.waitForConnected(forwardTimeoutMs)) { return false; }
+
+    QJsonObject message{{"urls", QJsonArray::fromStringList(urls)}};
+    socket.write(QJsonDocument(message).toJson(QJsonDocument::Compact) + '\n');
+    if (!socket.waitForBytesWritten(forwardTimeoutMs)) { return false; }
+
+    while (!socket.canReadLine())
+        if (!socket.waitForReadyRead(forwardTimeoutMs)) { return false; }
+    return socket.readLine().trimmed() == "ok";
+}
+
+bool SingleInstance::listen()
+{
+    // the lock holder owns the socket; tryLock() takes over a lock whose
+    // process is gone, and only then is a leftover socket removed
+    lock = std::make_unique<QLockFile>(QDir::temp().filePath(serverName() + ".lock"));
+    lock->setStaleLockTime(0);
+    if (!lock->tryLock())
+    {
+        qWarning() << "Another instance holds" << serverName() << "but did not answer, running without it";
+        return false;
+    }
+
+    if (server.listen(serverName())) { return true; }
+
+    // nobody holds the lock, so the socket is left over from a crash
+    QLocalServer::removeServer(serverName());
+    if (!server.listen(serverName()))
+    {
+        qWarning() << "Could not listen on" << serverName() << server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void SingleInstance::accept()
+{
+    while (QLocalSocket* socket = server.nextPendingConnection())
+    {
+        buffers.insert(socket, {});
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket] { readMessage(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket] {
+            buffers.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+// one JSON line per connection: {"urls": [...]}
+void SingleInstance::readMessage(QLocalSocket *socket)
+{
+    auto buf = buffers.find(socket);
+    if (buf == buffers.end())
+    {
+        socket->readAll();
+        return;
+    }
+    QByteArray &data = *buf;
+    data += socket->readAll();
+
+    int end = data.indexOf('\n');
+    if (end < 0)
+    {
+        if (data.size() > maxMessageBytes)
+        {
+            buffers.remove(socket);
+            socket->disconnectFromServer();
+        }
+        return;
+    }
+
+    QJsonObject message = QJsonDocument::fromJson(data.left(end)).object();
+    buffers.remove(socket);
+
+    QStringList urls;
+    for (const QJsonValue &v : message.value("urls").toArray())
+        urls << v.toString();
+
+    socket->write("ok\n");
+    socket->disconnectFromServer();
+
+    emit received(urls);
+}
@@ -0,0 +1,50 @@
+#ifndef SINGLE_INSTANCE_HPP
+#define SINGLE_INSTANCE_HPP
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLockFile>
+#include <QHash>
+#include <QStringList>
+#include <memory>
+
+class QLocalSocket;
+
+
+// One window per user: a second launch hands its command-line URLs to the
+// running instance over a local socket and exits instead of starting a
+// fresh process. Only the current user can connect.
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SingleInstance(QObject *parent = nullptr);
+
+    // true once a running instance has taken the URLs, this one should exit
+    bool forward(const QStringList &urls);
+
+    // becomes the instance later launches forward to; fails while another
+    // instance holds the lock, even one too busy to answer forward()
+    bool listen();
+
+signals:
+    void received(const QStringList &urls);
+
+private:
+    QLocalServer server;
+    std::unique_ptr<QLockFile> lock;
+    QHash<QLocalSocket*, QByteArray> buffers;
+
+    void accept();
+    void readMessage(QLocalSocket *socket);
+
+    static QString serverName();
+
+    // a second launch is waiting on these before it gives up and starts alone
+    static constexpr int forwardTimeoutMs = 2000;
+    static constexpr int maxMessageBytes = 1024 * 1024;
+};
+
+
+#endif // SINGLE_INSTANCE_HPP
@@ -0,0 +1,77 @@
+#include "startup_trace.hpp"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDateTime>
+#include <QCoreApplication>
+#include <cstdio>
+
+
+// ---------- state ----------
+namespace
+{
+    struct Trace
+    {
+        QElapsedTimer clock;
+        QFile out;
+        bool enabled = false;
+        qint64 lastNs = 0;
+    };
+
+    Trace& trace()
+    {
+        static Trace t;
+        return t;
+    }
+}
+
+
+// ---------- StartupTrace ----------
+void StartupTrace::begin()
+{
+    Trace &t = trace();
+    t.clock.start();
+
+    QByteArray target = qgetenv("YTDLP_GUI_STARTUP_TRACE");
+    if (target.isEmpty() || target == "0") { return; }
+
+    if (target == "1" || target == "stderr")
+        t.enabled = t.out.open(stderr, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    else
+    {
+        t.out.setFileName(QString::fromLocal8Bit(target));
+        t.enabled = t.out.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+    }
+
+    if (t.enabled)
+        t.out.write(QString("# startup %1, pid %2\n")
+                        .arg(QDateTime::currentDateTime().toString(Qt::ISODateWithMs))
+                        .arg(QCoreApplication::applicationPid()).toUtf8());
+}
+
+void StartupTrace::mark(const QString &phase)
+{
+    Trace &t = trace();
+    if (!t.enabled) { return; }
+
+    // total since begin() and the time this phase took
+    qint64 now = t.clock.nsecsElapsed();
+    QString line = QString("%1 ms  +%2 ms  %3\n")
+                       .arg(now / 1e6, 9, 'f', 1)
+                       .arg((now - t.lastNs) / 1e6, 7, 'f', 1)
+                       .arg(phase);
+    t.lastNs = now;
+
+    t.out.write(line.toUtf8());
+    t.out.flush();
+}
+
+qint64 StartupTrace::elapsedMs()
+{
+    return trace().clock.isValid() ? trace().clock.elapsed() : 0;
+}
+
+bool StartupTrace::isEnabled()
+{
+    return trace().enabled;
+}
@@ -0,0 +1,24 @@
+#ifndef STARTUP_TRACE_HPP
+#define STARTUP_TRACE_HPP
+
+#include <QString>
+
+
+// Timestamps per start-up phase, for tracking time to interactive on slow
+// machines. Off unless YTDLP_GUI_STARTUP_TRACE is set: "1" or "stderr"
+// prints to stderr, anything else is a file the lines are appended to.
+// Each line is written and flushed right away, so a hang still shows
+// the last phase that was reached.
+class StartupTrace
+{
+public:
+    // the zero point, called first thing in main()
+    static void begin();
+
+    static void mark(const QString &phase);
+    static qint64 elapsedMs();
+    static bool isEnabled();
+};
+
+
+#endif // STARTUP_TRACE_HPP
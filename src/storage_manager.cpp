@@ -0,0 +1,218 @@
+#include "storage_manager.hpp"
+
+#include <QStorageInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QDebug>
+
+
+// ---------- Helper functions ----------
+static const FormatInfo* findFormat(const VideoMetadata &md, const QString &id)
+{
+    for (const FormatInfo &f : md.formats)
+        if (f.id == id) { return &f; }
+    return nullptr;
+}
+
+// the listed size, or bitrate times duration when the site gives none
+static qint64 streamBytes(const FormatInfo &f, double duration)
+{
+    if (f.filesize > 0) { return f.filesize; }
+    return qint64(f.tbr * 1000 / 8 * duration);
+}
+
+
+// ---------- StorageManager ----------
+StorageManager::StorageManager(DownloadQueue *queue, QObject *parent)
+    : QObject(parent), queue(queue)
+{
+    queue->addGate([this](int id) { return fits(id); });
+
+    connect(queue, &DownloadQueue::jobStarted, this, [this](int id) { running.insert(id); });
+    connect(queue, &DownloadQueue::jobQueued, this, [this](int id) { running.remove(id); });
+    connect(queue, &DownloadQueue::jobFinished, this, [this](int id, int, JobState state) { jobFinished(id, state); });
+
+    // the space may have been freed by something else meanwhile
+    recheck.setSingleShot(true);
+    recheck.setInterval(recheckMs);
+    connect(&recheck, &QTimer::timeout, this, [this] {
+        freeSpace.clear();
+        this->queue->wake();
+    });
+}
+
+void StorageManager::setScratchDir(const QString &dir)
+{
+    scratch.clear();
+    scratchVolume.clear();
+    if (dir.isEmpty()) { return; }
+
+    if (!QDir().mkpath(dir))
+    {
+        qWarning() << "Could not create scratch directory" << dir;
+        return;
+    }
+    scratch = QDir(dir).absolutePath();
+    scratchVolume = volumeOf(scratch);
+}
+
+QString StorageManager::tempDirFor(const QString &outputDir)
+{
+    if (scratch.isEmpty()) { return {}; }
+
+    // yt-dlp would copy every finished file across, better to write in place
+    QString volume = volumeOf(outputDir);
+    if (volume.isEmpty() || volume != scratchVolume)
+    {
+        if (!skippedDirs.contains(outputDir))
+        {
+            skippedDirs.insert(outputDir);
+            emit scratchSkipped(outputDir, scratch);
+        }
+        return {};
+    }
+    return scratch;
+}
+
+void StorageManager::track(int id, const QString &outputDir, qint64 peakBytes)
+{
+    tracked.insert(id, {volumeOf(outputDir), qMax<qint64>(0, peakBytes)});
+}
+
+qint64 StorageManager::peakBytes(const VideoMetadata &md, const QString &formatId, bool converted)
+{
+    if (formatId.isEmpty()) { return 0; }
+
+    qint64 total = 0;
+    const QStringList ids = formatId.split('+');
+    for (const QString &id : ids)
+    {
+        const FormatInfo* f = findFormat(md, id);
+        if (!f) { return 0; }
+        total += streamBytes(*f, md.duration);
+    }
+
+    // the merged or converted output is written while the streams still exist
+    if (ids.size() > 1 || converted)
+        total *= 2;
+    return total;
+}
+
+qint64 StorageManager::freeBytes(const QString &path)
+{
+    QString volume = volumeOf(path);
+    return volume.isEmpty() ? -1 : freeOn(volume);
+}
+
+bool StorageManager::fits(int id)
+{
+    auto it = tracked.constFind(id);
+    if (it == tracked.constEnd() || it->volume.isEmpty()) { return true; }
+
+    qint64 free = freeOn(it->volume);
+    if (free < 0) { return true; }
+
+    qint64 available = free - reservedOn(it->volume);
+    if (available - it->need >= minFree)
+    {
+        heldVolumes.remove(it->volume);
+        return true;
+    }
+
+    // nothing running there will free any space, waiting would never end
+    if (!isBusy(it->volume))
+    {
+        failTooLarge(id, it->need + minFree, qMax<qint64>(0, available));
+        return false;
+    }
+
+    // a full disk would otherwise be reported for every queued job
+    if (!heldVolumes.contains(it->volume))
+    {
+        heldVolumes.insert(it->volume);
+        emit held(it->volume, id, it->need + minFree, qMax<qint64>(0, available));
+    }
+    if (!recheck.isActive())
+        recheck.start();
+    return false;
+}
+
+// free space already counts what running jobs wrote, not what they will
+qint64 StorageManager::reservedOn(const QString &volume) const
+{
+    qint64 reserved = 0;
+    for (int id : running)
+    {
+        auto it = tracked.constFind(id);
+        if (it == tracked.constEnd() || it->volume != volume) { continue; }
+
+        const DownloadJob* j = queue->job(id);
+        qint64 written = j ? j->receivedBytes : 0;
+        reserved += qMax<qint64>(0, it->need - written);
+    }
+    return reserved;
+}
+
+bool StorageManager::isBusy(const QString &volume) const
+{
+    for (int id : running)
+    {
+        auto it = tracked.constFind(id);
+        if (it != tracked.constEnd() && it->volume == volume) { return true; }
+    }
+    return false;
+}
+
+// gates run while the queue walks its pending list, so the job is failed
+// once that is over
+void StorageManager::failTooLarge(int id, qint64 needed, qint64 available)
+{
+    if (failing.contains(id)) { return; }
+    failing.insert(id);
+
+    QString error = QString("Not enough space: needs %1 MB, %2 MB available")
+                        .arg(needed / (1024 * 1024)).arg(available / (1024 * 1024));
+    QMetaObject::invokeMethod(this, [this, id, error] {
+        failing.remove(id);
+        queue->fail(id, error);
+    }, Qt::QueuedConnection);
+}
+
+QString StorageManager::volumeOf(const QString &path)
+{
+    auto it = volumes.constFind(path);
+    if (it != volumes.constEnd()) { return *it; }
+
+    QStorageInfo info(path);
+    QString root = info.isValid() ? info.rootPath() : QString();
+
+    // not created yet, asked again next time
+    if (!root.isEmpty())
+        volumes.insert(path, root);
+    return root;
+}
+
+qint64 StorageManager::freeOn(const QString &volume)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    FreeSpace &f = freeSpace[volume];
+    if (now - f.at > freeSpaceMaxAgeMs)
+    {
+        QStorageInfo info(volume);
+        f.bytes = info.isValid() && info.isReady() ? info.bytesAvailable() : -1;
+        f.at = now;
+    }
+    return f.bytes;
+}
+
+void StorageManager::jobFinished(int id, JobState state)
+{
+    running.remove(id);
+
+    // a failed job may be retried under the same id
+    if (state != JobState::Failed)
+        tracked.remove(id);
+
+    // what it wrote is on disk now, or removed
+    freeSpace.clear();
+}
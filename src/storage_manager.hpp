@@ -0,0 +1,97 @@
+#ifndef STORAGE_MANAGER_HPP
+#define STORAGE_MANAGER_HPP
+
+#include "download_queue.hpp"
+#include "metadata_service.hpp"
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+
+// Keeps downloads from filling up a volume. Every job is registered with
+// its destination and the space it needs at its peak (from cached
+// metadata, 0 when unknown); it only starts once the volume's free space,
+// minus what the jobs running there still have to write, leaves room for
+// it plus a margin. Held jobs are checked again every few seconds; one
+// that does not fit while nothing else runs on its volume is failed.
+// A scratch directory for .part files and fragments is only used when it
+// is on the destination's volume, so finished files are renamed into
+// place instead of copied across devices.
+class StorageManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StorageManager(DownloadQueue *queue, QObject *parent = nullptr);
+
+    // space always left free on a volume
+    void setMinFree(qint64 bytes) { minFree = qMax<qint64>(0, bytes); }
+    qint64 minimumFree() const { return minFree; }
+
+    // an empty dir writes .part files next to the final ones
+    void setScratchDir(const QString &dir);
+    QString scratchDir() const { return scratch; }
+
+    // the scratch dir if it is on outputDir's volume, otherwise empty
+    QString tempDirFor(const QString &outputDir);
+
+    // call before enqueue() with nextJobId(), the job may start right away
+    void track(int id, const QString &outputDir, qint64 peakBytes);
+
+    // what fetching formatId needs on disk at its peak: the streams plus
+    // the merged or converted file written next to them; 0 when unknown
+    static qint64 peakBytes(const VideoMetadata &md, const QString &formatId, bool converted);
+
+    // bytes available on the volume holding path, -1 when unknown
+    qint64 freeBytes(const QString &path);
+
+signals:
+    // once per volume until a job there may start again
+    void held(const QString &volume, int id, qint64 needed, qint64 available);
+    void scratchSkipped(const QString &outputDir, const QString &scratchDir);
+
+private:
+    struct Job
+    {
+        QString volume;
+        qint64 need = 0;
+    };
+
+    struct FreeSpace
+    {
+        qint64 bytes = -1;
+        qint64 at = 0;
+    };
+
+    DownloadQueue* queue;
+    qint64 minFree = 512LL * 1024 * 1024;
+    QString scratch;
+    QString scratchVolume;
+
+    QHash<int, Job> tracked;
+    QSet<int> running;
+    QSet<QString> heldVolumes;
+    QSet<int> failing;
+    QSet<QString> skippedDirs;
+
+    // mount lookups are slow, free space is read at most once a second
+    QHash<QString, QString> volumes;
+    QHash<QString, FreeSpace> freeSpace;
+    QTimer recheck;
+
+    bool fits(int id);
+    qint64 reservedOn(const QString &volume) const;
+    bool isBusy(const QString &volume) const;
+    void failTooLarge(int id, qint64 needed, qint64 available);
+    QString volumeOf(const QString &path);
+    qint64 freeOn(const QString &volume);
+    void jobFinished(int id, JobState state);
+
+    static constexpr qint64 freeSpaceMaxAgeMs = 1000;
+    static constexpr int recheckMs = 5000;
+};
+
+
+#endif // STORAGE_MANAGER_HPP
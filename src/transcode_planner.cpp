@@ -0,0 +1,146 @@
+#include "transcode_planner.hpp"
+
+#include <QSettings>
+
+
+// ---------- Helper functions ----------
+static double audioBitrate(const FormatInfo &f)
+{
+    return f.abr > 0 ? f.abr : f.tbr;
+}
+
+// "avc1.640028" -> "avc1", "mp4a.40.2" -> "mp4a"
+static QString codecFamily(const QString &codec)
+{
+    return codec.section('.', 0, 0).toLower();
+}
+
+static const FormatInfo* findFormat(const VideoMetadata &md, const QString &id)
+{
+    for (const FormatInfo &f : md.formats)
+        if (f.id == id) { return &f; }
+    return nullptr;
+}
+
+
+// ---------- TranscodePlan ----------
+QString TranscodePlan::modeName() const
+{
+    switch (mode)
+    {
+        case TranscodeMode::Remux: return "remux";
+        case TranscodeMode::Copy: return "stream copy";
+        case TranscodeMode::Transcode: return "transcode";
+    }
+    return {};
+}
+
+QString TranscodePlan::describe() const
+{
+    QString from = sourceCodecs.isEmpty() ? "unknown codecs" : sourceCodecs;
+    QString s = QString("%1 -> %2: %3").arg(from, target, modeName());
+    if (!formatId.isEmpty())
+        s += QString(" (format %1)").arg(formatId);
+    return s;
+}
+
+TranscodeSettings TranscodeSettings::fromSettings()
+{
+    QSettings s;
+    TranscodeSettings t;
+    t.threads = qMax(0, s.value("transcode_threads", 0).toInt());
+    t.preset = s.value("transcode_preset", t.preset).toString();
+    return t;
+}
+
+
+// ---------- planning ----------
+bool canCopyAudio(const QString &acodec, const QString &target)
+{
+    QString family = codecFamily(acodec);
+    if (target == "opus") { return family == "opus"; }
+    if (target == "mp3") { return family == "mp3"; }
+    return false;
+}
+
+TranscodePlan planAudio(const VideoMetadata &md, const QString &target, const QString &quality, bool loudnorm)
+{
+    TranscodePlan plan;
+    plan.target = target;
+
+    const FormatInfo* best = nullptr;
+    const FormatInfo* copyable = nullptr;
+    for (const FormatInfo &f : md.formats)
+    {
+        if (!f.hasAudio() || f.hasVideo()) { continue; }
+        if (!best || audioBitrate(f) > audioBitrate(*best))
+            best = &f;
+        if (canCopyAudio(f.acodec, target) && (!copyable || audioBitrate(f) > audioBitrate(*copyable)))
+            copyable = &f;
+    }
+    if (!best) { return plan; }
+
+    // a copy is lossless; a somewhat lower bitrate beats a generation loss
+    bool wantsCopy = (quality == "Best") && !loudnorm;
+    if (wantsCopy && copyable && audioBitrate(*copyable) >= 0.75 * audioBitrate(*best))
+    {
+        plan.mode = TranscodeMode::Copy;
+        plan.formatId = copyable->id;
+        plan.sourceCodecs = codecFamily(copyable->acodec);
+        return plan;
+    }
+
+    plan.mode = TranscodeMode::Transcode;
+    plan.formatId = best->id;
+    plan.sourceCodecs = codecFamily(best->acodec);
+    return plan;
+}
+
+TranscodePlan planVideo(const VideoMetadata &md, int maxHeight, const QString &container)
+{
+    TranscodePlan plan;
+    plan.mode = TranscodeMode::Remux;
+    plan.target = container;
+    plan.formatId = md.resolveVideoFormat(maxHeight, container);
+
+    QStringList codecs;
+    const QStringList ids = plan.formatId.split('+', Qt::SkipEmptyParts);
+    for (const QString &id : ids)
+    {
+        const FormatInfo* f = findFormat(md, id);
+        if (!f) { continue; }
+        if (f->hasVideo()) codecs << codecFamily(f->vcodec);
+        if (f->hasAudio()) codecs << codecFamily(f->acodec);
+    }
+    plan.sourceCodecs = codecs.join('+');
+    return plan;
+}
+
+
+// ---------- encoder arguments ----------
+QStringList audioEncoderArgs(const QString &target, const QString &quality, const TranscodeSettings &settings)
+{
+    QStringList args;
+
+    // compression_level trades encoder CPU for size at the same quality;
+    // lame counts down (0 = slowest), libopus up (10 = slowest)
+    int level = 0;
+    if (target == "opus")
+    {
+        args << "-c:a" << "libopus" << "-b:a" << (quality == "Best" ? "160k" : quality);
+        level = (settings.preset == "fast") ? 3 : (settings.preset == "quality") ? 10 : 8;
+    }
+    else
+    {
+        args << "-c:a" << "libmp3lame";
+        if (quality == "Best")
+            args << "-q:a" << "0";
+        else
+            args << "-b:a" << quality;
+        level = (settings.preset == "fast") ? 7 : (settings.preset == "quality") ? 0 : 3;
+    }
+    args << "-compression_level" << QString::number(level);
+
+    args << "-threads" << QString::number(settings.threads > 0 ? settings.threads : 1);
+    return args;
+}
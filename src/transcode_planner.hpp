@@ -0,0 +1,53 @@
+#ifndef TRANSCODE_PLANNER_HPP
+#define TRANSCODE_PLANNER_HPP
+
+#include "metadata_service.hpp"
+#include <QString>
+#include <QStringList>
+
+
+enum class TranscodeMode {
+    Remux,      // streams copied into another container (yt-dlp's merger)
+    Copy,       // audio stream copied, only the container changes
+    Transcode   // audio re-encoded by ffmpeg
+};
+
+// Cheapest way from the listed formats to the requested output.
+struct TranscodePlan
+{
+    TranscodeMode mode = TranscodeMode::Transcode;
+    QString formatId;        // "-f" value to download, empty to keep the default
+    QString sourceCodecs;    // e.g. "opus" or "avc1+mp4a"
+    QString target;
+
+    QString modeName() const;
+    QString describe() const;
+};
+
+// Encoder knobs for the Transcode case. threads 0 means one per worker,
+// the pool provides the parallelism.
+struct TranscodeSettings
+{
+    int threads = 0;
+    QString preset = "balanced";     // fast | balanced | quality
+
+    // keys: transcode_threads, transcode_preset
+    static TranscodeSettings fromSettings();
+};
+
+// Prefers a source stream that can be copied to the target codec as long
+// as it is not much worse than the best audio; with a bitrate or loudness
+// request nothing can be copied and the best stream is re-encoded.
+TranscodePlan planAudio(const VideoMetadata &md, const QString &target, const QString &quality, bool loudnorm);
+
+// yt-dlp never re-encodes while merging, so this only reports the codecs
+// of the formats resolveVideoFormat() picked.
+TranscodePlan planVideo(const VideoMetadata &md, int maxHeight, const QString &container);
+
+bool canCopyAudio(const QString &acodec, const QString &target);
+
+// -c:a and friends for one target codec, quality ("Best" or "192k") and preset
+QStringList audioEncoderArgs(const QString &target, const QString &quality, const TranscodeSettings &settings);
+
+
+#endif // TRANSCODE_PLANNER_HPP
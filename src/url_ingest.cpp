@@ -0,0 +1,222 @@
+#include "url_ingest.hpp"
+#include "download_archive.hpp"
+
+#include <QUrl>
+#include <QUrlQuery>
+#include <QSet>
+
+
+// ---------- Helper functions ----------
+static bool endsUrl(QChar c)
+{
+    if (c.isSpace()) { return true; }
+    switch (c.unicode())
+    {
+        case '<': case '>': case '"': case '\'': case '`':
+        case '{': case '}': case '|': case '\\': case '^':
+            return true;
+    }
+    return c.unicode() < 0x20;
+}
+
+static bool isTrailingPunctuation(QChar c)
+{
+    switch (c.unicode())
+    {
+        case '.': case ',': case ';': case ':': case '!': case '?':
+        case ')': case ']': case '*':
+            return true;
+    }
+    return false;
+}
+
+static bool isOnSite(const QString &host, const QString &domain)
+{
+    return host == domain || host.endsWith('.' + domain);
+}
+
+static bool isTrackingParam(const QString &host, const QString &name)
+{
+    // click ids and analytics, meaningless to any site's content
+    static const QSet<QString> anywhere{
+        "fbclid", "gclid", "dclid", "msclkid", "yclid", "twclid", "mc_cid", "mc_eid", "_ga", "_gl",
+    };
+    if (name.startsWith("utm_") || anywhere.contains(name)) { return true; }
+
+    // ordinary words elsewhere ("?ref=" may pick a branch or a page), so
+    // only dropped where they are known to be share tracking
+    struct SiteParams
+    {
+        QStringList domains;
+        QSet<QString> names;
+    };
+    static const QList<SiteParams> sites{
+        {{"youtube.com", "youtu.be", "youtube-nocookie.com"}, {"si", "feature", "pp", "ab_channel"}},
+        {{"spotify.com", "soundcloud.com"}, {"si"}},
+        {{"twitter.com", "x.com"}, {"ref_src", "ref_url", "embeds_referring_euri"}},
+        {{"instagram.com"}, {"igshid", "igsh"}},
+        {{"bilibili.com"}, {"spm_id_from", "share_source", "vd_source"}},
+    };
+    for (const SiteParams &site : sites)
+    {
+        if (!site.names.contains(name)) { continue; }
+        for (const QString &domain : site.domains)
+            if (isOnSite(host, domain)) { return true; }
+    }
+    return false;
+}
+
+static bool isYouTubeId(const QString &id)
+{
+    if (id.size() != 11) { return false; }
+    for (QChar c : id)
+        if (!c.isLetterOrNumber() && c != '-' && c != '_') { return false; }
+    return true;
+}
+
+static bool isYouTubeHost(const QString &host)
+{
+    return host == "youtube.com" || host.endsWith(".youtube.com")
+        || host == "youtube-nocookie.com" || host.endsWith(".youtube-nocookie.com");
+}
+
+
+// ---------- CanonicalUrl ----------
+QString CanonicalUrl::key() const
+{
+    return id.isEmpty() ? url : DownloadArchive::key(extractor, id);
+}
+
+
+// ---------- scanning ----------
+QStringList scanUrls(QStringView text)
+{
+    QStringList out;
+    qsizetype pos = 0;
+
+    while ((pos = text.indexOf(u"http", pos, Qt::CaseInsensitive)) >= 0)
+    {
+        qsizetype start = pos;
+        qsizetype i = pos + 4;
+        if (i < text.size() && (text[i] == 's' || text[i] == 'S'))
+            i++;
+        if (text.mid(i, 3) != u"://")
+        {
+            pos = i;
+            continue;
+        }
+        i += 3;
+
+        // "xhttp://" is not a URL start, "(http://" and "=http://" are
+        if (start > 0 && text[start - 1].isLetterOrNumber())
+        {
+            pos = i;
+            continue;
+        }
+
+        qsizetype end = i;
+        while (end < text.size() && !endsUrl(text[end]))
+            end++;
+        pos = end;
+
+        // "(see https://a.b/c)." keeps neither the ")" nor the "."
+        QStringView url = text.mid(start, end - start);
+        while (url.size() > i - start && isTrailingPunctuation(url.back()))
+        {
+            if (url.back() == ')' && url.count(u'(') >= url.count(u')')) { break; }
+            url.chop(1);
+        }
+        if (url.size() > i - start)
+            out << url.toString();
+    }
+    return out;
+}
+
+
+// ---------- canonical form ----------
+CanonicalUrl canonicalizeUrl(const QString &text)
+{
+    CanonicalUrl c;
+    QUrl url(text.trimmed(), QUrl::TolerantMode);
+    if (!url.isValid() || url.host().isEmpty()) { return c; }
+
+    QString scheme = url.scheme().toLower();
+    if (scheme != "http" && scheme != "https") { return c; }
+
+    QString host = url.host().toLower();
+    QString path = url.path();
+    QUrlQuery query(url);
+
+    // --- YouTube: every spelling of a video is watch?v=ID ---
+    QString ytId;
+    if (host == "youtu.be")
+        ytId = path.mid(1).section('/', 0, 0);
+    else if (isYouTubeHost(host))
+    {
+        if (path == "/watch")
+            ytId = query.queryItemValue("v");
+        else
+        {
+            static const QStringList prefixes{"/shorts/", "/embed/", "/live/", "/v/"};
+            for (const QString &p : prefixes)
+                if (path.startsWith(p))
+                    ytId = path.mid(p.size()).section('/', 0, 0);
+        }
+
+        if (path == "/playlist" && query.hasQueryItem("list"))
+        {
+            c.url = "https://www.youtube.com/playlist?list=" + query.queryItemValue("list");
+            return c;
+        }
+    }
+    if (!ytId.isEmpty() && isYouTubeId(ytId))
+    {
+        c.extractor = "youtube";
+        c.id = ytId;
+        c.url = "https://www.youtube.com/watch?v=" + ytId;
+
+        // a video inside a playlist is still a playlist request
+        if (query.hasQueryItem("list"))
+        {
+            c.url += "&list=" + query.queryItemValue("list");
+            c.extractor.clear();
+            c.id.clear();
+        }
+        return c;
+    }
+
+    // --- Vimeo: vimeo.com/<number>, or vimeo.com/<number>/<hash> when unlisted ---
+    if ((host == "vimeo.com" || host == "www.vimeo.com") && path.size() > 1)
+    {
+        QString id = path.mid(1).section('/', 0, 0);
+        bool numeric = false;
+        id.toLongLong(&numeric);
+        if (numeric)
+        {
+            // the hash is the only way in to an unlisted video
+            QString hash = path.mid(1).section('/', 1, 1);
+            bool isHash = !hash.isEmpty();
+            for (QChar ch : hash)
+                if (!ch.isLetterOrNumber()) { isHash = false; }
+
+            c.extractor = "vimeo";
+            c.id = id;
+            c.url = "https://vimeo.com/" + id + (isHash ? "/" + hash : QString());
+            return c;
+        }
+    }
+
+    // --- anything else: lowercase host, no fragment, no tracking parameters ---
+    QUrlQuery kept;
+    const auto items = query.queryItems(QUrl::FullyEncoded);
+    for (const auto &item : items)
+        if (!isTrackingParam(host, item.first.toLower()))
+            kept.addQueryItem(item.first, item.second);
+
+    url.setScheme(scheme);
+    url.setHost(host);
+    url.setFragment(QString());
+    url.setQuery(kept.isEmpty() ? QString() : kept.query(QUrl::FullyEncoded), QUrl::StrictMode);
+    c.url = url.toString(QUrl::FullyEncoded);
+    return c;
+}
@@ -0,0 +1,31 @@
+#ifndef URL_INGEST_HPP
+#define URL_INGEST_HPP
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+
+// A URL reduced to what identifies the video: tracking parameters and
+// fragments are gone, and known sites are rewritten to one form, so
+// "youtu.be/ID?si=..." and "m.youtube.com/watch?v=ID&feature=share" are
+// the same entry.
+struct CanonicalUrl
+{
+    QString url;         // what gets downloaded
+    QString extractor;   // archive naming ("youtube"), empty when the site isn't known
+    QString id;
+
+    bool isValid() const { return !url.isEmpty(); }
+
+    // the download archive key when the video is known, otherwise the URL
+    QString key() const;
+};
+
+// every http(s) URL in free text: one per line, pasted prose, HTML, CSV
+QStringList scanUrls(QStringView text);
+
+CanonicalUrl canonicalizeUrl(const QString &url);
+
+
+#endif // URL_INGEST_HPP